@@ -0,0 +1,403 @@
+// Zero-copy reader for the `cs2_dumper.bin` file generated with `-f bin`.
+//
+// Point it at the file's bytes (e.g. a memory map):
+//
+//     auto dump = cs2_dumper_bin::Dump::open(data, size);
+//
+//     if (auto module = dump->module("client.dll"))
+//         if (auto cls = module->cls("C_BaseEntity"))
+//             if (auto field = cls->field("m_iHealth"))
+//                 std::ptrdiff_t offset = field->offset();
+//
+// Lookups are binary searches over the sorted tables in the file, and nothing is parsed or copied
+// up front. Requires C++17 and a little-endian target.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+namespace cs2_dumper_bin {
+    constexpr std::uint32_t version = 2;
+
+    namespace detail {
+        enum Table : std::size_t {
+            strings,
+            modules,
+            classes,
+            fields,
+            field_index,
+            metadata,
+            enums,
+            members,
+            entries,
+            table_count,
+        };
+
+        constexpr std::size_t record_len[table_count] = {1, 40, 40, 24, 4, 24, 24, 16, 16};
+
+        struct Range {
+            std::size_t first = 0;
+            std::size_t count = 0;
+        };
+    }
+
+    class Dump;
+
+    class Field {
+    public:
+        std::string_view name() const;
+        std::string_view type_name() const;
+        std::int32_t offset() const;
+
+    private:
+        friend class Class;
+
+        Field(const Dump* dump, std::size_t offset) : dump_(dump), offset_(offset) {}
+
+        const Dump* dump_;
+        std::size_t offset_;
+    };
+
+    enum class MetadataKind : std::uint32_t {
+        Unknown = 0,
+        NetworkChangeCallback = 1,
+        NetworkVarNames = 2,
+    };
+
+    struct Metadata {
+        MetadataKind kind;
+        std::string_view name;
+        std::string_view type_name;
+    };
+
+    class Class {
+    public:
+        std::string_view name() const;
+        std::optional<std::string_view> parent() const;
+
+        // Fields in declaration order.
+        std::size_t field_count() const;
+        Field field_at(std::size_t i) const;
+
+        std::optional<Field> field(std::string_view name) const;
+
+        std::size_t metadata_count() const;
+        Metadata metadata_at(std::size_t i) const;
+
+    private:
+        friend class Module;
+
+        Class(const Dump* dump, std::size_t offset) : dump_(dump), offset_(offset) {}
+
+        const Dump* dump_;
+        std::size_t offset_;
+    };
+
+    class Enum {
+    public:
+        std::string_view name() const;
+        std::uint32_t alignment() const;
+
+        // Members in declaration order.
+        std::size_t member_count() const;
+        std::string_view member_name(std::size_t i) const;
+        std::int64_t member_value(std::size_t i) const;
+
+    private:
+        friend class Module;
+
+        Enum(const Dump* dump, std::size_t offset) : dump_(dump), offset_(offset) {}
+
+        const Dump* dump_;
+        std::size_t offset_;
+    };
+
+    class Module {
+    public:
+        std::string_view name() const;
+
+        std::size_t class_count() const;
+        Class class_at(std::size_t i) const;
+        std::optional<Class> cls(std::string_view name) const;
+
+        std::size_t enum_count() const;
+        Enum enum_at(std::size_t i) const;
+        std::optional<Enum> enm(std::string_view name) const;
+
+        std::optional<std::uint64_t> offset(std::string_view name) const;
+        std::optional<std::uint64_t> iface(std::string_view name) const;
+
+    private:
+        friend class Dump;
+
+        Module(const Dump* dump, std::size_t offset) : dump_(dump), offset_(offset) {}
+
+        const Dump* dump_;
+        std::size_t offset_;
+    };
+
+    class Dump {
+    public:
+        // Validates the header and the table bounds. The data must outlive the returned object, and
+        // the returned object must outlive the modules, classes and fields obtained from it.
+        static std::optional<Dump> open(const void* data, std::size_t size) {
+            Dump dump(static_cast<const std::uint8_t*>(data), size);
+
+            if (size < 8 + (detail::table_count + 1) * 8 || std::memcmp(data, "CS2D", 4) != 0 ||
+                dump.u32_at(4) != version)
+                return std::nullopt;
+
+            for (std::size_t i = 0; i < detail::table_count; ++i) {
+                dump.tables_[i] = dump.range_at(8 + i * 8);
+
+                const auto& table = dump.tables_[i];
+
+                if (table.first > size || table.count > (size - table.first) / detail::record_len[i])
+                    return std::nullopt;
+            }
+
+            dump.buttons_ = dump.range_at(8 + detail::table_count * 8);
+
+            if (dump.buttons_.first + dump.buttons_.count > dump.tables_[detail::entries].count)
+                return std::nullopt;
+
+            return dump;
+        }
+
+        std::size_t module_count() const {
+            return tables_[detail::modules].count;
+        }
+
+        Module module_at(std::size_t i) const {
+            return Module(this, record(detail::modules, i));
+        }
+
+        std::optional<Module> module(std::string_view name) const {
+            if (auto i = search({0, module_count()}, name, [this](std::size_t i) {
+                    return record(detail::modules, i);
+                }))
+                return Module(this, record(detail::modules, *i));
+
+            return std::nullopt;
+        }
+
+        // Buttons of `client.dll`.
+        std::optional<std::uint64_t> button(std::string_view name) const {
+            return entry(buttons_, name);
+        }
+
+    private:
+        friend class Module;
+        friend class Class;
+        friend class Field;
+        friend class Enum;
+
+        Dump(const std::uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+        std::size_t record(detail::Table table, std::size_t i) const {
+            return tables_[table].first + i * detail::record_len[table];
+        }
+
+        std::uint32_t u32_at(std::size_t offset) const {
+            std::uint32_t value = 0;
+
+            if (offset + 4 <= size_)
+                std::memcpy(&value, data_ + offset, 4);
+
+            return value;
+        }
+
+        std::uint64_t u64_at(std::size_t offset) const {
+            std::uint64_t value = 0;
+
+            if (offset + 8 <= size_)
+                std::memcpy(&value, data_ + offset, 8);
+
+            return value;
+        }
+
+        detail::Range range_at(std::size_t offset) const {
+            return {u32_at(offset), u32_at(offset + 4)};
+        }
+
+        std::optional<std::string_view> opt_str_at(std::size_t offset) const {
+            const auto start = u32_at(offset);
+
+            if (start == UINT32_MAX)
+                return std::nullopt;
+
+            const auto first = tables_[detail::strings].first + start;
+            const auto len = u32_at(offset + 4);
+
+            if (first + len > size_)
+                return std::nullopt;
+
+            return std::string_view(reinterpret_cast<const char*>(data_ + first), len);
+        }
+
+        std::string_view str_at(std::size_t offset) const {
+            return opt_str_at(offset).value_or(std::string_view());
+        }
+
+        // Binary searches `range` for a record whose name (the string at the start of the record)
+        // equals `name`.
+        template <typename F>
+        std::optional<std::size_t> search(detail::Range range, std::string_view name, F record) const {
+            auto lo = range.first;
+            auto hi = range.first + range.count;
+
+            while (lo < hi) {
+                const auto mid = lo + (hi - lo) / 2;
+                const auto cmp = str_at(record(mid)).compare(name);
+
+                if (cmp < 0)
+                    lo = mid + 1;
+                else if (cmp > 0)
+                    hi = mid;
+                else
+                    return mid;
+            }
+
+            return std::nullopt;
+        }
+
+        std::optional<std::uint64_t> entry(detail::Range range, std::string_view name) const {
+            if (auto i = search(range, name, [this](std::size_t i) { return record(detail::entries, i); }))
+                return u64_at(record(detail::entries, *i) + 8);
+
+            return std::nullopt;
+        }
+
+        const std::uint8_t* data_;
+        std::size_t size_;
+        detail::Range tables_[detail::table_count] = {};
+        detail::Range buttons_ = {};
+    };
+
+    inline std::string_view Field::name() const {
+        return dump_->str_at(offset_);
+    }
+
+    inline std::string_view Field::type_name() const {
+        return dump_->str_at(offset_ + 8);
+    }
+
+    inline std::int32_t Field::offset() const {
+        return static_cast<std::int32_t>(dump_->u32_at(offset_ + 16));
+    }
+
+    inline std::string_view Class::name() const {
+        return dump_->str_at(offset_);
+    }
+
+    inline std::optional<std::string_view> Class::parent() const {
+        return dump_->opt_str_at(offset_ + 8);
+    }
+
+    inline std::size_t Class::field_count() const {
+        return dump_->range_at(offset_ + 16).count;
+    }
+
+    inline Field Class::field_at(std::size_t i) const {
+        return Field(dump_, dump_->record(detail::fields, dump_->range_at(offset_ + 16).first + i));
+    }
+
+    inline std::optional<Field> Class::field(std::string_view name) const {
+        const auto first_index = dump_->u32_at(offset_ + 32);
+
+        const auto field = [this](std::size_t i) {
+            return dump_->record(detail::fields, dump_->u32_at(dump_->record(detail::field_index, i)));
+        };
+
+        if (auto i = dump_->search({first_index, field_count()}, name, field))
+            return Field(dump_, field(*i));
+
+        return std::nullopt;
+    }
+
+    inline std::size_t Class::metadata_count() const {
+        return dump_->range_at(offset_ + 24).count;
+    }
+
+    inline Metadata Class::metadata_at(std::size_t i) const {
+        const auto offset = dump_->record(detail::metadata, dump_->range_at(offset_ + 24).first + i);
+
+        return {
+            static_cast<MetadataKind>(dump_->u32_at(offset)),
+            dump_->str_at(offset + 8),
+            dump_->str_at(offset + 16),
+        };
+    }
+
+    inline std::string_view Enum::name() const {
+        return dump_->str_at(offset_);
+    }
+
+    inline std::uint32_t Enum::alignment() const {
+        return dump_->u32_at(offset_ + 16);
+    }
+
+    inline std::size_t Enum::member_count() const {
+        return dump_->range_at(offset_ + 8).count;
+    }
+
+    inline std::string_view Enum::member_name(std::size_t i) const {
+        return dump_->str_at(dump_->record(detail::members, dump_->range_at(offset_ + 8).first + i));
+    }
+
+    inline std::int64_t Enum::member_value(std::size_t i) const {
+        const auto offset = dump_->record(detail::members, dump_->range_at(offset_ + 8).first + i);
+
+        return static_cast<std::int64_t>(dump_->u64_at(offset + 8));
+    }
+
+    inline std::string_view Module::name() const {
+        return dump_->str_at(offset_);
+    }
+
+    inline std::size_t Module::class_count() const {
+        return dump_->range_at(offset_ + 8).count;
+    }
+
+    inline Class Module::class_at(std::size_t i) const {
+        return Class(dump_, dump_->record(detail::classes, dump_->range_at(offset_ + 8).first + i));
+    }
+
+    inline std::optional<Class> Module::cls(std::string_view name) const {
+        const auto record = [this](std::size_t i) { return dump_->record(detail::classes, i); };
+
+        if (auto i = dump_->search(dump_->range_at(offset_ + 8), name, record))
+            return Class(dump_, record(*i));
+
+        return std::nullopt;
+    }
+
+    inline std::size_t Module::enum_count() const {
+        return dump_->range_at(offset_ + 16).count;
+    }
+
+    inline Enum Module::enum_at(std::size_t i) const {
+        return Enum(dump_, dump_->record(detail::enums, dump_->range_at(offset_ + 16).first + i));
+    }
+
+    inline std::optional<Enum> Module::enm(std::string_view name) const {
+        const auto record = [this](std::size_t i) { return dump_->record(detail::enums, i); };
+
+        if (auto i = dump_->search(dump_->range_at(offset_ + 16), name, record))
+            return Enum(dump_, record(*i));
+
+        return std::nullopt;
+    }
+
+    inline std::optional<std::uint64_t> Module::offset(std::string_view name) const {
+        return dump_->entry(dump_->range_at(offset_ + 24), name);
+    }
+
+    inline std::optional<std::uint64_t> Module::iface(std::string_view name) const {
+        return dump_->entry(dump_->range_at(offset_ + 32), name);
+    }
+}
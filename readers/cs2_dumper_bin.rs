@@ -0,0 +1,395 @@
+//! Zero-copy reader for the `cs2_dumper.bin` file generated with `-f bin`.
+//!
+//! Copy this file into your project, and point it at the file's bytes (e.g. a memory map):
+//!
+//! ```ignore
+//! let dump = cs2_dumper_bin::Dump::new(&bytes).unwrap();
+//!
+//! let offset = dump
+//!     .module("client.dll")
+//!     .and_then(|module| module.class("C_BaseEntity"))
+//!     .and_then(|class| class.field("m_iHealth"))
+//!     .map(|field| field.offset());
+//! ```
+//!
+//! Lookups are binary searches over the sorted tables in the file, and nothing is parsed or
+//! copied up front.
+
+#![allow(dead_code)]
+
+use std::cmp::Ordering;
+
+pub const MAGIC: &[u8; 4] = b"CS2D";
+pub const VERSION: u32 = 2;
+
+const TABLE_COUNT: usize = 9;
+
+const STRINGS: usize = 0;
+const MODULES: usize = 1;
+const CLASSES: usize = 2;
+const FIELDS: usize = 3;
+const FIELD_INDEX: usize = 4;
+const METADATA: usize = 5;
+const ENUMS: usize = 6;
+const MEMBERS: usize = 7;
+const ENTRIES: usize = 8;
+
+const RECORD_LEN: [usize; TABLE_COUNT] = [1, 40, 40, 24, 4, 24, 24, 16, 16];
+
+#[derive(Clone, Copy)]
+pub struct Dump<'a> {
+    data: &'a [u8],
+    tables: [(usize, usize); TABLE_COUNT],
+    buttons: (usize, usize),
+}
+
+impl<'a> Dump<'a> {
+    /// Validates the header and the table bounds. Returns `None` if the data is not a dump of a
+    /// supported version.
+    pub fn new(data: &'a [u8]) -> Option<Self> {
+        if data.get(..4)? != MAGIC || read_u32(data, 4)? != VERSION {
+            return None;
+        }
+
+        let mut tables = [(0, 0); TABLE_COUNT];
+
+        for (i, table) in tables.iter_mut().enumerate() {
+            let offset = read_u32(data, 8 + i * 8)? as usize;
+            let count = read_u32(data, 12 + i * 8)? as usize;
+
+            if offset.checked_add(count.checked_mul(RECORD_LEN[i])?)? > data.len() {
+                return None;
+            }
+
+            *table = (offset, count);
+        }
+
+        let buttons = read_range(data, 8 + TABLE_COUNT * 8)?;
+
+        if buttons.0.checked_add(buttons.1)? > tables[ENTRIES].1 {
+            return None;
+        }
+
+        Some(Self {
+            data,
+            tables,
+            buttons,
+        })
+    }
+
+    pub fn modules(&self) -> impl Iterator<Item = Module<'a>> + '_ {
+        let dump = *self;
+
+        (0..self.tables[MODULES].1).map(move |i| Module {
+            dump,
+            offset: dump.record(MODULES, i),
+        })
+    }
+
+    pub fn module(&self, name: &str) -> Option<Module<'a>> {
+        let i = self.search((0, self.tables[MODULES].1), name, |i| {
+            self.record(MODULES, i)
+        })?;
+
+        Some(Module {
+            dump: *self,
+            offset: self.record(MODULES, i),
+        })
+    }
+
+    /// Returns the value of a button in `client.dll`.
+    pub fn button(&self, name: &str) -> Option<u64> {
+        self.entry(self.buttons, name)
+    }
+
+    pub fn buttons(&self) -> impl Iterator<Item = (&'a str, u64)> + '_ {
+        self.entries(self.buttons)
+    }
+
+    fn entries(&self, range: (usize, usize)) -> impl Iterator<Item = (&'a str, u64)> + '_ {
+        let dump = *self;
+
+        (range.0..range.0 + range.1).map(move |i| {
+            let offset = dump.record(ENTRIES, i);
+
+            (dump.str_at(offset), dump.u64_at(offset + 8))
+        })
+    }
+
+    fn entry(&self, range: (usize, usize), name: &str) -> Option<u64> {
+        let i = self.search(range, name, |i| self.record(ENTRIES, i))?;
+
+        Some(self.u64_at(self.record(ENTRIES, i) + 8))
+    }
+
+    /// Binary searches `range` for a record whose name (the `Str` at the start of the record)
+    /// equals `name`.
+    fn search(
+        &self,
+        range: (usize, usize),
+        name: &str,
+        record: impl Fn(usize) -> usize,
+    ) -> Option<usize> {
+        let (mut lo, mut hi) = (range.0, range.0 + range.1);
+
+        while lo < hi {
+            let mid = lo + (hi - lo) / 2;
+
+            match self.str_at(record(mid)).as_bytes().cmp(name.as_bytes()) {
+                Ordering::Less => lo = mid + 1,
+                Ordering::Greater => hi = mid,
+                Ordering::Equal => return Some(mid),
+            }
+        }
+
+        None
+    }
+
+    #[inline]
+    fn record(&self, table: usize, i: usize) -> usize {
+        self.tables[table].0 + i * RECORD_LEN[table]
+    }
+
+    #[inline]
+    fn u32_at(&self, offset: usize) -> u32 {
+        read_u32(self.data, offset).unwrap_or_default()
+    }
+
+    #[inline]
+    fn u64_at(&self, offset: usize) -> u64 {
+        self.data
+            .get(offset..offset + 8)
+            .map_or(0, |b| u64::from_le_bytes(b.try_into().unwrap()))
+    }
+
+    #[inline]
+    fn range_at(&self, offset: usize) -> (usize, usize) {
+        read_range(self.data, offset).unwrap_or_default()
+    }
+
+    /// Resolves the `Str` at `offset`. Missing or invalid strings are returned as empty.
+    fn str_at(&self, offset: usize) -> &'a str {
+        self.opt_str_at(offset).unwrap_or_default()
+    }
+
+    fn opt_str_at(&self, offset: usize) -> Option<&'a str> {
+        let start = self.u32_at(offset);
+
+        if start == u32::MAX {
+            return None;
+        }
+
+        let start = self.tables[STRINGS].0 + start as usize;
+        let len = self.u32_at(offset + 4) as usize;
+
+        std::str::from_utf8(self.data.get(start..start + len)?).ok()
+    }
+}
+
+#[derive(Clone, Copy)]
+pub struct Module<'a> {
+    dump: Dump<'a>,
+    offset: usize,
+}
+
+impl<'a> Module<'a> {
+    pub fn name(&self) -> &'a str {
+        self.dump.str_at(self.offset)
+    }
+
+    pub fn classes(&self) -> impl Iterator<Item = Class<'a>> + '_ {
+        let (first, count) = self.dump.range_at(self.offset + 8);
+
+        (first..first + count).map(move |i| Class {
+            dump: self.dump,
+            offset: self.dump.record(CLASSES, i),
+        })
+    }
+
+    pub fn class(&self, name: &str) -> Option<Class<'a>> {
+        let range = self.dump.range_at(self.offset + 8);
+        let i = self
+            .dump
+            .search(range, name, |i| self.dump.record(CLASSES, i))?;
+
+        Some(Class {
+            dump: self.dump,
+            offset: self.dump.record(CLASSES, i),
+        })
+    }
+
+    pub fn enums(&self) -> impl Iterator<Item = Enum<'a>> + '_ {
+        let (first, count) = self.dump.range_at(self.offset + 16);
+
+        (first..first + count).map(move |i| Enum {
+            dump: self.dump,
+            offset: self.dump.record(ENUMS, i),
+        })
+    }
+
+    pub fn enum_(&self, name: &str) -> Option<Enum<'a>> {
+        let range = self.dump.range_at(self.offset + 16);
+        let i = self
+            .dump
+            .search(range, name, |i| self.dump.record(ENUMS, i))?;
+
+        Some(Enum {
+            dump: self.dump,
+            offset: self.dump.record(ENUMS, i),
+        })
+    }
+
+    pub fn offset(&self, name: &str) -> Option<u64> {
+        self.dump.entry(self.dump.range_at(self.offset + 24), name)
+    }
+
+    pub fn offsets(&self) -> impl Iterator<Item = (&'a str, u64)> + '_ {
+        self.dump.entries(self.dump.range_at(self.offset + 24))
+    }
+
+    pub fn interface(&self, name: &str) -> Option<u64> {
+        self.dump.entry(self.dump.range_at(self.offset + 32), name)
+    }
+
+    pub fn interfaces(&self) -> impl Iterator<Item = (&'a str, u64)> + '_ {
+        self.dump.entries(self.dump.range_at(self.offset + 32))
+    }
+}
+
+#[derive(Clone, Copy)]
+pub struct Class<'a> {
+    dump: Dump<'a>,
+    offset: usize,
+}
+
+impl<'a> Class<'a> {
+    pub fn name(&self) -> &'a str {
+        self.dump.str_at(self.offset)
+    }
+
+    pub fn parent(&self) -> Option<&'a str> {
+        self.dump.opt_str_at(self.offset + 8)
+    }
+
+    /// Returns the fields in declaration order.
+    pub fn fields(&self) -> impl Iterator<Item = Field<'a>> + '_ {
+        let (first, count) = self.dump.range_at(self.offset + 16);
+
+        (first..first + count).map(move |i| Field {
+            dump: self.dump,
+            offset: self.dump.record(FIELDS, i),
+        })
+    }
+
+    pub fn field(&self, name: &str) -> Option<Field<'a>> {
+        let (_, count) = self.dump.range_at(self.offset + 16);
+        let first_index = self.dump.u32_at(self.offset + 32) as usize;
+
+        let field = |i| {
+            let index = self.dump.u32_at(self.dump.record(FIELD_INDEX, i)) as usize;
+
+            self.dump.record(FIELDS, index)
+        };
+
+        let i = self.dump.search((first_index, count), name, field)?;
+
+        Some(Field {
+            dump: self.dump,
+            offset: field(i),
+        })
+    }
+
+    pub fn metadata(&self) -> impl Iterator<Item = Metadata<'a>> + '_ {
+        let (first, count) = self.dump.range_at(self.offset + 24);
+
+        (first..first + count).map(move |i| {
+            let offset = self.dump.record(METADATA, i);
+
+            let name = self.dump.str_at(offset + 8);
+            let type_name = self.dump.str_at(offset + 16);
+
+            match self.dump.u32_at(offset) {
+                1 => Metadata::NetworkChangeCallback { name },
+                2 => Metadata::NetworkVarNames { name, type_name },
+                _ => Metadata::Unknown { name },
+            }
+        })
+    }
+}
+
+#[derive(Clone, Copy)]
+pub struct Field<'a> {
+    dump: Dump<'a>,
+    offset: usize,
+}
+
+impl<'a> Field<'a> {
+    pub fn name(&self) -> &'a str {
+        self.dump.str_at(self.offset)
+    }
+
+    pub fn type_name(&self) -> &'a str {
+        self.dump.str_at(self.offset + 8)
+    }
+
+    pub fn offset(&self) -> i32 {
+        self.dump.u32_at(self.offset + 16) as i32
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Metadata<'a> {
+    Unknown { name: &'a str },
+    NetworkChangeCallback { name: &'a str },
+    NetworkVarNames { name: &'a str, type_name: &'a str },
+}
+
+#[derive(Clone, Copy)]
+pub struct Enum<'a> {
+    dump: Dump<'a>,
+    offset: usize,
+}
+
+impl<'a> Enum<'a> {
+    pub fn name(&self) -> &'a str {
+        self.dump.str_at(self.offset)
+    }
+
+    pub fn alignment(&self) -> u32 {
+        self.dump.u32_at(self.offset + 16)
+    }
+
+    /// Returns the number of members, not a size in bytes.
+    pub fn member_count(&self) -> u32 {
+        self.dump.u32_at(self.offset + 20)
+    }
+
+    /// Returns the members in declaration order.
+    pub fn members(&self) -> impl Iterator<Item = (&'a str, i64)> + '_ {
+        let (first, count) = self.dump.range_at(self.offset + 8);
+
+        (first..first + count).map(move |i| {
+            let offset = self.dump.record(MEMBERS, i);
+
+            (
+                self.dump.str_at(offset),
+                self.dump.u64_at(offset + 8) as i64,
+            )
+        })
+    }
+}
+
+#[inline]
+fn read_u32(data: &[u8], offset: usize) -> Option<u32> {
+    Some(u32::from_le_bytes(
+        data.get(offset..offset + 4)?.try_into().ok()?,
+    ))
+}
+
+#[inline]
+fn read_range(data: &[u8], offset: usize) -> Option<(usize, usize)> {
+    Some((
+        read_u32(data, offset)? as usize,
+        read_u32(data, offset + 4)? as usize,
+    ))
+}
@@ -7,20 +7,36 @@ use log::debug;
 use memflow::prelude::v1::*;
 
 use pelite::pattern;
-use pelite::pe64::{Pe, PeView};
+use pelite::pe64::Pe;
+
+use super::{AnalysisContext, Analyzer, ImageParts};
 
 use crate::source2::KeyButton;
+use crate::target::Target;
 
 pub type ButtonMap = BTreeMap<String, imem>;
 
-pub fn buttons<P: Process + MemoryView>(process: &mut P) -> Result<ButtonMap> {
-    let module = process.module_by_name("client.dll")?;
+pub const BUTTON_MODULES: &[&str] = &["client.dll"];
+
+pub fn buttons<P: Target>(process: &mut P, ctx: &AnalysisContext) -> Result<ButtonMap> {
+    if !ctx.filter.includes_module(Analyzer::Buttons, "client.dll") {
+        return Ok(ButtonMap::new());
+    }
 
-    let buf = process
-        .read_raw(module.base, module.size as _)
-        .data_part()?;
+    if let Some(buttons) = ctx.reuse("client.dll", |baseline| baseline.buttons.clone()) {
+        ctx.cache.release("client.dll", ImageParts::CODE);
+
+        return Ok(buttons);
+    }
 
-    let view = PeView::from_bytes(&buf)?;
+    let image = ctx
+        .cache
+        .image_by_name(process, "client.dll", ImageParts::CODE)?;
+    let module = &image.module;
+
+    let view = image.view()?;
+
+    let _span = ctx.span("scan", "client.dll");
 
     let mut save = [0; 2];
 
@@ -31,7 +47,16 @@ pub fn buttons<P: Process + MemoryView>(process: &mut P) -> Result<ButtonMap> {
         bail!("outdated button list pattern");
     }
 
-    read_buttons(process, &module, module.base + save[1])
+    let mut buttons = read_buttons(process, module, module.base + save[1])?;
+
+    // The list has to be walked in full either way, but only the buttons that were asked for are
+    // kept.
+    buttons.retain(|name, _| {
+        ctx.filter
+            .includes_name(Analyzer::Buttons, "client.dll", name)
+    });
+
+    Ok(buttons)
 }
 
 fn read_buttons(
@@ -0,0 +1,244 @@
+use std::fmt;
+use std::str::FromStr;
+
+use anyhow::{Error, Result, bail};
+
+use serde::{Deserialize, Serialize};
+
+/// The analyzers a [`Filter`] can select.
+#[derive(Clone, Copy, Debug, Deserialize, Eq, PartialEq, Serialize)]
+#[serde(rename_all = "snake_case")]
+pub enum Analyzer {
+    Buttons,
+    Interfaces,
+    Offsets,
+    Schemas,
+}
+
+impl Analyzer {
+    const ALL: [(Self, &'static str); 4] = [
+        (Self::Buttons, "buttons"),
+        (Self::Interfaces, "interfaces"),
+        (Self::Offsets, "offsets"),
+        (Self::Schemas, "schemas"),
+    ];
+
+    pub fn name(self) -> &'static str {
+        Self::ALL.iter().find(|(a, _)| *a == self).unwrap().1
+    }
+}
+
+/// Restricts an analysis to a part of its results. Analyzers, modules and names outside of the
+/// filter are skipped before anything is read for them.
+///
+/// An empty filter includes everything.
+#[derive(Clone, Debug, Default, Deserialize, Eq, PartialEq, Serialize)]
+#[serde(transparent)]
+pub struct Filter {
+    rules: Vec<FilterRule>,
+}
+
+impl Filter {
+    pub fn new(rules: impl IntoIterator<Item = FilterRule>) -> Self {
+        Self {
+            rules: rules.into_iter().collect(),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.rules.is_empty()
+    }
+
+    /// Returns whether the analyzer has to run at all.
+    pub fn includes(&self, analyzer: Analyzer) -> bool {
+        self.is_empty() || self.rules_for(analyzer).next().is_some()
+    }
+
+    /// Returns whether the analyzer has to look at the given module.
+    pub fn includes_module(&self, analyzer: Analyzer, module_name: &str) -> bool {
+        self.is_empty()
+            || self
+                .rules_for(analyzer)
+                .any(|rule| glob_match(&rule.module, module_name))
+    }
+
+    /// Returns whether the analyzer has to read the button, interface, offset, class or enum with
+    /// the given name.
+    pub fn includes_name(&self, analyzer: Analyzer, module_name: &str, name: &str) -> bool {
+        self.is_empty()
+            || self
+                .rules_for(analyzer)
+                .any(|rule| glob_match(&rule.module, module_name) && glob_match(&rule.name, name))
+    }
+
+    /// Returns a filter that only includes what this one includes of the given analyzer.
+    pub fn restrict(&self, analyzer: Analyzer) -> Self {
+        if self.is_empty() {
+            return Self::new([FilterRule {
+                analyzer: Some(analyzer),
+                module: "*".to_string(),
+                name: "*".to_string(),
+            }]);
+        }
+
+        Self::new(self.rules_for(analyzer).map(|rule| FilterRule {
+            analyzer: Some(analyzer),
+            ..rule.clone()
+        }))
+    }
+
+    fn rules_for(&self, analyzer: Analyzer) -> impl Iterator<Item = &FilterRule> {
+        self.rules
+            .iter()
+            .filter(move |rule| rule.analyzer.is_none_or(|a| a == analyzer))
+    }
+}
+
+/// A single rule of a [`Filter`], written as `ANALYZER[:MODULE[/NAME]]`.
+///
+/// The analyzer is one of `buttons`, `interfaces`, `offsets` and `schemas`, or `*` for all of
+/// them. The module and name are globs, in which `*` matches any number of characters and `?`
+/// matches a single one. Both default to `*`.
+#[derive(Clone, Debug, Deserialize, Eq, PartialEq, Serialize)]
+pub struct FilterRule {
+    analyzer: Option<Analyzer>,
+    module: String,
+    name: String,
+}
+
+impl FromStr for FilterRule {
+    type Err = Error;
+
+    fn from_str(s: &str) -> Result<Self> {
+        let (analyzer, rest) = s.split_once(':').unwrap_or((s, ""));
+        let (module, name) = rest.split_once('/').unwrap_or((rest, ""));
+
+        let analyzer = match analyzer {
+            "*" => None,
+            _ => match Analyzer::ALL.iter().find(|(_, name)| *name == analyzer) {
+                Some((analyzer, _)) => Some(*analyzer),
+                None => bail!("unknown analyzer: {}", analyzer),
+            },
+        };
+
+        let or_any = |glob: &str| match glob {
+            "" => "*".to_string(),
+            _ => glob.to_string(),
+        };
+
+        Ok(Self {
+            analyzer,
+            module: or_any(module),
+            name: or_any(name),
+        })
+    }
+}
+
+impl fmt::Display for Filter {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        for (i, rule) in self.rules.iter().enumerate() {
+            if i > 0 {
+                write!(f, ", ")?;
+            }
+
+            write!(f, "{}", rule)?;
+        }
+
+        Ok(())
+    }
+}
+
+impl fmt::Display for FilterRule {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let analyzer = self.analyzer.map_or("*", Analyzer::name);
+
+        write!(f, "{}:{}/{}", analyzer, self.module, self.name)
+    }
+}
+
+/// Matches `text` against a glob, in which `*` matches any number of characters and `?` matches
+/// a single one.
+fn glob_match(glob: &str, text: &str) -> bool {
+    let (glob, text): (Vec<_>, Vec<_>) = (glob.chars().collect(), text.chars().collect());
+
+    let (mut g, mut t) = (0, 0);
+
+    // The position of the last `*`, and of the text it was matched against.
+    let mut star = None;
+
+    while t < text.len() {
+        match glob.get(g) {
+            Some('*') => {
+                star = Some((g, t));
+
+                g += 1;
+            }
+            Some(&c) if c == '?' || c == text[t] => {
+                g += 1;
+                t += 1;
+            }
+            _ => match star {
+                // Let the last `*` consume one more character and try again.
+                Some((star_g, star_t)) => {
+                    star = Some((star_g, star_t + 1));
+
+                    g = star_g + 1;
+                    t = star_t + 1;
+                }
+                None => return false,
+            },
+        }
+    }
+
+    glob[g..].iter().all(|&c| c == '*')
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn filter_rules() -> Result<()> {
+        let filter = Filter::new([
+            "schemas:client.dll".parse()?,
+            "offsets:*/dwLocalPlayer*".parse()?,
+        ]);
+
+        assert!(filter.includes(Analyzer::Schemas));
+        assert!(!filter.includes(Analyzer::Buttons));
+
+        assert!(filter.includes_module(Analyzer::Schemas, "client.dll"));
+        assert!(!filter.includes_module(Analyzer::Schemas, "server.dll"));
+        assert!(filter.includes_name(Analyzer::Schemas, "client.dll", "C_BaseEntity"));
+
+        assert!(filter.includes_module(Analyzer::Offsets, "engine2.dll"));
+        assert!(filter.includes_name(Analyzer::Offsets, "client.dll", "dwLocalPlayerPawn"));
+        assert!(!filter.includes_name(Analyzer::Offsets, "client.dll", "dwEntityList"));
+
+        assert!(Filter::default().includes_name(Analyzer::Buttons, "client.dll", "jump"));
+
+        // Restricting keeps the rules that apply to the analyzer, for it alone.
+        let restricted = filter.restrict(Analyzer::Offsets);
+
+        assert!(!restricted.includes(Analyzer::Schemas));
+        assert!(restricted.includes_name(Analyzer::Offsets, "client.dll", "dwLocalPlayerPawn"));
+        assert!(!restricted.includes_name(Analyzer::Offsets, "client.dll", "dwEntityList"));
+        assert!(
+            !Filter::default()
+                .restrict(Analyzer::Offsets)
+                .includes(Analyzer::Buttons)
+        );
+
+        assert_eq!(
+            "*:client.dll/C_?ase*".parse::<FilterRule>()?.to_string(),
+            "*:client.dll/C_?ase*"
+        );
+        assert!("dumps".parse::<FilterRule>().is_err());
+
+        assert!(glob_match("C_*Entity", "C_BaseEntity"));
+        assert!(glob_match("*a*b", "xaab"));
+        assert!(!glob_match("C_?Entity", "C_BaseEntity"));
+
+        Ok(())
+    }
+}
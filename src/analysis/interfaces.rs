@@ -6,46 +6,81 @@ use log::debug;
 
 use memflow::prelude::v1::*;
 
+use pelite::pe64::Pe;
 use pelite::pe64::exports::Export;
-use pelite::pe64::{Pe, PeView};
+
+use super::{AnalysisContext, Analyzer, ImageParts, par_map};
 
 use crate::source2::InterfaceReg;
+use crate::target::Target;
 
 pub type InterfaceMap = BTreeMap<String, BTreeMap<String, umem>>;
 
-pub fn interfaces<P: Process + MemoryView>(process: &mut P) -> Result<InterfaceMap> {
-    process
-        .module_list()?
-        .iter()
-        .filter(|module| module.name.as_ref() != "crashandler64.dll")
-        .filter_map(|module| {
-            let buf = process
-                .read_raw(module.base, module.size as _)
-                .data_part()
-                .ok()?;
-
-            let view = PeView::from_bytes(&buf).ok()?;
-
-            let ci_export = view
-                .exports()
-                .ok()?
-                .by()
-                .ok()?
-                .name("CreateInterface")
-                .ok()?;
-
-            if let Export::Symbol(symbol) = ci_export {
-                let list_addr = read_addr64_rip(process, module.base + symbol).ok()?;
-
-                return read_interfaces(process, module, list_addr)
-                    .ok()
-                    .filter(|ifaces| !ifaces.is_empty())
-                    .map(|ifaces| Ok((module.name.to_string(), ifaces)));
-            }
-
-            None
+pub fn interfaces<P>(process: &mut P, ctx: &AnalysisContext) -> Result<InterfaceMap>
+where
+    P: Target + Clone + Send,
+{
+    let modules: Vec<_> = process
+        .modules()?
+        .into_iter()
+        .filter(|module| {
+            module.name.as_ref() != "crashandler64.dll"
+                && ctx
+                    .filter
+                    .includes_module(Analyzer::Interfaces, &module.name)
         })
-        .collect()
+        .collect();
+
+    let map = par_map(process, ctx.jobs, &modules, |process, module| {
+        let module_name = module.name.as_ref();
+
+        // Unchanged modules without interfaces are absent from the previous result as well.
+        if let Some(ifaces) = ctx.reuse(module_name, |baseline| {
+            baseline
+                .interfaces
+                .as_ref()
+                .map(|ifaces| ifaces.get(module_name).cloned())
+        }) {
+            ctx.cache.release(module_name, ImageParts::EXPORTS);
+
+            return ifaces.map(|ifaces| (module_name.to_string(), ifaces));
+        }
+
+        let image = ctx.cache.image(process, module, ImageParts::EXPORTS).ok()?;
+        let view = image.view().ok()?;
+
+        let ci_export = view
+            .exports()
+            .ok()?
+            .by()
+            .ok()?
+            .name("CreateInterface")
+            .ok()?;
+
+        if let Export::Symbol(symbol) = ci_export {
+            let list_addr = read_addr64_rip(process, module.base + symbol).ok()?;
+
+            return read_interfaces(process, module, list_addr)
+                .ok()
+                .map(|mut ifaces| {
+                    ifaces.retain(|name, _| {
+                        ctx.filter
+                            .includes_name(Analyzer::Interfaces, module_name, name)
+                    });
+
+                    ifaces
+                })
+                .filter(|ifaces| !ifaces.is_empty())
+                .map(|ifaces| (module.name.to_string(), ifaces));
+        }
+
+        None
+    })
+    .into_iter()
+    .flatten()
+    .collect();
+
+    Ok(map)
 }
 
 fn read_interfaces(
@@ -1,35 +1,593 @@
 pub use buttons::*;
+pub use filter::*;
 pub use interfaces::*;
 pub use offsets::*;
 pub use schemas::*;
+pub use strings::*;
 
 use std::any::type_name;
+use std::collections::{BTreeMap, BTreeSet};
+use std::mem;
+use std::ops::{BitOr, Range};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
 
 use anyhow::Result;
 
-use log::{error, info};
+use log::{debug, error, info};
 
 use memflow::prelude::v1::*;
 
+use pelite::image::{IMAGE_DIRECTORY_ENTRY_EXPORT, IMAGE_SCN_CNT_CODE, IMAGE_SCN_MEM_EXECUTE};
+use pelite::pe64::{Pe, PeView};
+
+use crate::metrics::{Metrics, Span};
+use crate::target::Target;
+
 mod buttons;
+mod filter;
 mod interfaces;
 mod offsets;
+mod scanner;
 mod schemas;
+mod strings;
 
 #[derive(Debug)]
 pub struct AnalysisResult {
     pub buttons: ButtonMap,
+
+    /// The filter the analysis was restricted to.
+    pub filter: Filter,
+
+    /// Where the offset patterns matched, if hints are enabled.
+    pub hints: HintMap,
+
     pub interfaces: InterfaceMap,
     pub offsets: OffsetMap,
     pub schemas: SchemaMap,
 }
 
-pub fn analyze_all<P: Process + MemoryView>(process: &mut P) -> Result<AnalysisResult> {
-    let buttons = analyze(process, buttons);
+/// State shared by all analyzers during an [`analyze_all`] call.
+pub struct AnalysisContext {
+    pub baseline: Option<Baseline>,
+    pub cache: ModuleCache,
+    pub filter: Filter,
 
-    info!("found {} buttons", buttons.len());
+    /// The locations of the offset patterns in the previous run, if hints are enabled.
+    pub hints: Option<HintMap>,
+
+    pub metrics: Option<Arc<Metrics>>,
+    pub strings: StringCache,
+
+    /// The maximum number of worker threads to use per stage. A value of `1` runs everything on
+    /// the calling thread.
+    pub jobs: usize,
+}
+
+impl AnalysisContext {
+    /// Returns the result of a previous run for the given module, if the module did not change
+    /// since.
+    pub fn reuse<T>(&self, module_name: &str, f: impl FnOnce(&Baseline) -> Option<T>) -> Option<T> {
+        self.baseline
+            .as_ref()
+            .filter(|baseline| baseline.modules.contains(module_name))
+            .and_then(f)
+    }
+
+    /// Starts a span of the `--metrics` report, if enabled.
+    pub fn span(&self, category: &'static str, name: impl Into<String>) -> Option<Span<'_>> {
+        self.metrics
+            .as_ref()
+            .map(|metrics| metrics.span(category, name))
+    }
+}
+
+/// The results of a previous run, used to skip the analysis of modules that did not change since.
+#[derive(Debug, Default)]
+pub struct Baseline {
+    /// The names of the modules that did not change since the previous run.
+    pub modules: BTreeSet<String>,
+
+    /// The names of the type scopes whose previously generated files are still up to date.
+    pub schemas: BTreeSet<String>,
+
+    pub buttons: Option<ButtonMap>,
+    pub interfaces: Option<InterfaceMap>,
+    pub offsets: Option<OffsetMap>,
+}
+
+impl Baseline {
+    /// Drops previous results that are empty, which are most likely the result of a failed
+    /// analyzer rather than of a module without any matches.
+    pub fn without_empty(mut self) -> Self {
+        self.buttons = self.buttons.filter(|buttons| !buttons.is_empty());
+        self.interfaces = self.interfaces.filter(|ifaces| !ifaces.is_empty());
+        self.offsets = self.offsets.filter(|offsets| !offsets.is_empty());
+
+        self
+    }
+}
+
+/// The granularity at which module images are read from the target.
+const PAGE_LEN: usize = 0x1000;
+
+/// The parts of a module image that are read besides its headers.
+#[derive(Clone, Copy, Debug, Default, Eq, PartialEq)]
+pub struct ImageParts(u8);
+
+impl ImageParts {
+    /// The executable sections, which is all that pattern scans look at.
+    pub const CODE: Self = Self(1 << 0);
+
+    /// The export directory, including the export names.
+    pub const EXPORTS: Self = Self(1 << 1);
+
+    pub fn contains(self, other: Self) -> bool {
+        self.0 & other.0 == other.0
+    }
+}
+
+impl BitOr for ImageParts {
+    type Output = Self;
+
+    fn bitor(self, other: Self) -> Self {
+        Self(self.0 | other.0)
+    }
+}
+
+/// A partial copy of a module image read from the target process.
+///
+/// The buffer spans the whole image so that it can be viewed as usual, but only the pages of the
+/// headers and of the requested [`ImageParts`] are read into it. All other pages are zeroed.
+pub struct ModuleImage {
+    pub module: ModuleInfo,
+    pub buf: Vec<u8>,
+
+    parts: ImageParts,
+
+    /// Whether each page of the buffer was read.
+    pages: Vec<bool>,
+}
+
+impl ModuleImage {
+    #[inline]
+    pub fn view(&self) -> Result<PeView<'_>> {
+        Ok(PeView::from_bytes(&self.buf)?)
+    }
+}
+
+type ImageSlot = Arc<Mutex<Option<Arc<ModuleImage>>>>;
+
+#[derive(Default)]
+struct CacheEntry {
+    slot: ImageSlot,
+
+    /// The parts that each of the outstanding expected readers asked for.
+    readers: Vec<ImageParts>,
+}
+
+impl CacheEntry {
+    /// Removes one expected reader of the given parts, and returns the parts that the remaining
+    /// readers asked for.
+    fn remove_reader(&mut self, parts: ImageParts) -> ImageParts {
+        if let Some(i) = self.readers.iter().position(|p| *p == parts) {
+            self.readers.swap_remove(i);
+        }
+
+        self.readers
+            .iter()
+            .fold(ImageParts::default(), |acc, parts| acc | *parts)
+    }
+}
+
+#[derive(Default)]
+struct CacheStats {
+    bytes_read: usize,
+    read_time: Duration,
+}
+
+/// Shares module images between analyzers, so that each image is read from the target at most
+/// once per [`analyze_all`] call.
+///
+/// Only images with outstanding expected reads are retained. Once the last expected reader has
+/// fetched an image, or [released](Self::release) its read, the cache drops its reference to it.
+#[derive(Default)]
+pub struct ModuleCache {
+    entries: Mutex<BTreeMap<String, CacheEntry>>,
+    stats: Mutex<CacheStats>,
+}
+
+impl ModuleCache {
+    /// Registers one more upcoming read of the given parts of a module.
+    pub fn expect(&self, module_name: &str, parts: ImageParts) {
+        let mut entries = self.entries.lock().unwrap();
+
+        entries
+            .entry(module_name.to_string())
+            .or_default()
+            .readers
+            .push(parts);
+    }
+
+    /// Withdraws an expected read of a module that won't happen after all, e.g. because the
+    /// previous result of the module was reused.
+    pub fn release(&self, module_name: &str, parts: ImageParts) {
+        let mut entries = self.entries.lock().unwrap();
+
+        if let Some(entry) = entries.get_mut(module_name) {
+            entry.remove_reader(parts);
+
+            if entry.readers.is_empty() {
+                entries.remove(module_name);
+            }
+        }
+    }
+
+    pub fn image<P: Target>(
+        &self,
+        process: &mut P,
+        module: &ModuleInfo,
+        parts: ImageParts,
+    ) -> Result<Arc<ModuleImage>> {
+        let name = module.name.as_ref();
+
+        // The first reader also reads the parts that the other expected readers asked for.
+        let (slot, parts) = {
+            let mut entries = self.entries.lock().unwrap();
+
+            match entries.get_mut(name) {
+                Some(entry) => {
+                    let slot = entry.slot.clone();
+                    let parts = parts | entry.remove_reader(parts);
+
+                    if entry.readers.is_empty() {
+                        entries.remove(name);
+                    }
+
+                    (slot, parts)
+                }
+                None => (ImageSlot::default(), parts),
+            }
+        };
+
+        // Readers of the same module wait here for the first one to finish, while readers of
+        // other modules are unaffected.
+        let mut image = slot.lock().unwrap();
+
+        if let Some(image) = image.as_ref().filter(|image| image.parts.contains(parts)) {
+            return Ok(image.clone());
+        }
+
+        let read = self.read_image(process, module, parts, image.as_deref())?;
+
+        Ok(image.insert(read).clone())
+    }
+
+    pub fn image_by_name<P: Target>(
+        &self,
+        process: &mut P,
+        module_name: &str,
+        parts: ImageParts,
+    ) -> Result<Arc<ModuleImage>> {
+        let module = process.module(module_name)?;
+
+        self.image(process, &module, parts)
+    }
+
+    /// Reads the headers and the given parts of a module image. Pages that are already present
+    /// in `prev` are copied from there instead of being read again.
+    fn read_image<P: Target>(
+        &self,
+        process: &mut P,
+        module: &ModuleInfo,
+        parts: ImageParts,
+        prev: Option<&ModuleImage>,
+    ) -> Result<Arc<ModuleImage>> {
+        let now = Instant::now();
+
+        let (mut buf, mut pages, parts) = match prev {
+            Some(prev) => (prev.buf.clone(), prev.pages.clone(), prev.parts | parts),
+            None => {
+                let len = module.size as usize;
+
+                (vec![0; len], vec![false; len.div_ceil(PAGE_LEN)], parts)
+            }
+        };
+
+        // The first page holds the size of the headers, which in turn hold the section table and
+        // the data directories.
+        let mut bytes_read = read_pages(process, module.base, &mut buf, &mut pages, [0..PAGE_LEN])?;
+
+        let headers_len = PeView::from_bytes(&buf)?.optional_header().SizeOfHeaders as usize;
+
+        bytes_read += read_pages(process, module.base, &mut buf, &mut pages, [0..headers_len])?;
+
+        let ranges = part_ranges(PeView::from_bytes(&buf)?, parts);
+
+        bytes_read += read_pages(process, module.base, &mut buf, &mut pages, ranges)?;
+
+        let elapsed = now.elapsed();
+
+        debug!(
+            "read module image: {} ({} of {} bytes) in {:.2?}",
+            module.name,
+            bytes_read,
+            buf.len(),
+            elapsed
+        );
+
+        let mut stats = self.stats.lock().unwrap();
+
+        stats.bytes_read += bytes_read;
+        stats.read_time += elapsed;
+
+        Ok(Arc::new(ModuleImage {
+            module: module.clone(),
+            buf,
+            parts,
+            pages,
+        }))
+    }
+}
+
+/// Returns the byte ranges of the given parts of an image.
+fn part_ranges(view: PeView<'_>, parts: ImageParts) -> Vec<Range<usize>> {
+    let mut ranges = Vec::new();
+
+    if parts.contains(ImageParts::CODE) {
+        ranges.extend(
+            view.section_headers()
+                .iter()
+                .filter(|section| {
+                    section.Characteristics & (IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE) != 0
+                })
+                .map(|section| {
+                    let start = section.VirtualAddress as usize;
+
+                    start..start + section.VirtualSize as usize
+                }),
+        );
+    }
+
+    if parts.contains(ImageParts::EXPORTS) {
+        if let Some(dir) = view.data_directory().get(IMAGE_DIRECTORY_ENTRY_EXPORT) {
+            let start = dir.VirtualAddress as usize;
+
+            ranges.push(start..start + dir.Size as usize);
+        }
+    }
+
+    ranges
+}
+
+/// Reads every page overlapping `ranges` that wasn't read yet into `buf` in a single batch, and
+/// returns the number of bytes read.
+fn read_pages(
+    mem: &mut impl MemoryView,
+    base: Address,
+    buf: &mut [u8],
+    pages: &mut [bool],
+    ranges: impl IntoIterator<Item = Range<usize>>,
+) -> Result<usize> {
+    let runs = missing_runs(buf.len(), pages, ranges);
+
+    let mut batcher = mem.batcher();
+
+    let mut rest = buf;
+    let mut offset = 0;
+
+    for run in &runs {
+        let (_, tail) = mem::take(&mut rest).split_at_mut(run.start - offset);
+        let (chunk, tail) = tail.split_at_mut(run.len());
+
+        batcher.read_raw_into(base + run.start, chunk);
+
+        rest = tail;
+        offset = run.end;
+    }
+
+    batcher.commit_rw().data_part()?;
+
+    drop(batcher);
+
+    Ok(runs.iter().map(|run| run.len()).sum())
+}
+
+/// Marks every page overlapping `ranges` as read, and returns the byte ranges of the pages that
+/// weren't read before. Adjacent pages are merged into a single range.
+fn missing_runs(
+    len: usize,
+    pages: &mut [bool],
+    ranges: impl IntoIterator<Item = Range<usize>>,
+) -> Vec<Range<usize>> {
+    let mut wanted = vec![false; pages.len()];
+
+    for range in ranges {
+        let end = range.end.min(len);
+        let start = range.start.min(end);
+
+        for page in start / PAGE_LEN..end.div_ceil(PAGE_LEN) {
+            wanted[page] |= !pages[page];
+        }
+    }
 
-    let interfaces = analyze(process, interfaces);
+    let mut runs = Vec::new();
+    let mut page = 0;
+
+    while page < wanted.len() {
+        if !wanted[page] {
+            page += 1;
+
+            continue;
+        }
+
+        let start = page;
+
+        while page < wanted.len() && wanted[page] {
+            pages[page] = true;
+
+            page += 1;
+        }
+
+        runs.push(start * PAGE_LEN..(page * PAGE_LEN).min(len));
+    }
+
+    runs
+}
+
+/// Receives the schemas of an [`analyze_streaming`] call, a few type scopes at a time.
+pub type SchemaSink<'a> = dyn FnMut(SchemaMap) -> Result<()> + 'a;
+
+pub fn analyze_all<P>(
+    process: &mut P,
+    jobs: usize,
+    baseline: Option<Baseline>,
+    filter: Filter,
+    hints: Option<HintMap>,
+    metrics: Option<Arc<Metrics>>,
+) -> Result<AnalysisResult>
+where
+    P: Target + Clone + Send,
+{
+    analyze_with(process, jobs, baseline, filter, hints, metrics, None)
+}
+
+/// Like [`analyze_all`], but hands the schemas to `sink` as they are read instead of returning
+/// them, see [`stream_schemas`].
+///
+/// The schemas are read once all other analyzers are done, so that the images they scanned have
+/// been dropped by then.
+pub fn analyze_streaming<P>(
+    process: &mut P,
+    jobs: usize,
+    baseline: Option<Baseline>,
+    filter: Filter,
+    hints: Option<HintMap>,
+    metrics: Option<Arc<Metrics>>,
+    memory_budget: Option<usize>,
+    sink: &mut SchemaSink,
+) -> Result<AnalysisResult>
+where
+    P: Target + Clone + Send,
+{
+    analyze_with(
+        process,
+        jobs,
+        baseline,
+        filter,
+        hints,
+        metrics,
+        Some((memory_budget, sink)),
+    )
+}
+
+fn analyze_with<P>(
+    process: &mut P,
+    jobs: usize,
+    baseline: Option<Baseline>,
+    filter: Filter,
+    hints: Option<HintMap>,
+    metrics: Option<Arc<Metrics>>,
+    stream: Option<(Option<usize>, &mut SchemaSink)>,
+) -> Result<AnalysisResult>
+where
+    P: Target + Clone + Send,
+{
+    if let Some(baseline) = &baseline {
+        info!(
+            "reusing previous results of {} unchanged modules",
+            baseline.modules.len()
+        );
+    }
+
+    if !filter.is_empty() {
+        info!("restricting analysis to: {}", filter);
+    }
+
+    let ctx = AnalysisContext {
+        baseline,
+        cache: ModuleCache::default(),
+        filter,
+        hints,
+        metrics,
+        strings: StringCache::default(),
+        jobs: jobs.max(1),
+    };
+
+    let filter = &ctx.filter;
+
+    // Only the images of modules that are included by the filter are ever read.
+    let module_names: Vec<_> = BUTTON_MODULES
+        .iter()
+        .copied()
+        .filter(|module_name| filter.includes_module(Analyzer::Buttons, module_name))
+        .chain(
+            OFFSET_MODULES
+                .iter()
+                .map(|(module_name, _)| *module_name)
+                .filter(|module_name| filter.includes_module(Analyzer::Offsets, module_name)),
+        )
+        .chain(
+            SCHEMA_MODULES
+                .iter()
+                .copied()
+                .filter(|_| filter.includes(Analyzer::Schemas)),
+        )
+        .collect();
+
+    // Buttons, offsets and the schema system are all found by pattern scans.
+    for module_name in &module_names {
+        ctx.cache.expect(module_name, ImageParts::CODE);
+    }
+
+    // `interfaces` reads the exports of every included module once.
+    for module_name in module_names.iter().collect::<BTreeSet<_>>() {
+        if filter.includes_module(Analyzer::Interfaces, module_name) {
+            ctx.cache.expect(module_name, ImageParts::EXPORTS);
+        }
+    }
+
+    let streaming = stream.is_some();
+
+    let (buttons, interfaces, (offsets, hints), schemas) = if ctx.jobs > 1 {
+        thread::scope(|s| {
+            let buttons = spawn_analyzer(s, process, &ctx, Analyzer::Buttons, buttons);
+            let interfaces = spawn_analyzer(s, process, &ctx, Analyzer::Interfaces, interfaces);
+            let offsets = spawn_analyzer(s, process, &ctx, Analyzer::Offsets, offsets);
+
+            let schemas =
+                (!streaming).then(|| spawn_analyzer(s, process, &ctx, Analyzer::Schemas, schemas));
+
+            (
+                buttons.join().unwrap(),
+                interfaces.join().unwrap(),
+                offsets.join().unwrap(),
+                schemas.map_or_else(SchemaMap::default, |schemas| schemas.join().unwrap()),
+            )
+        })
+    } else {
+        (
+            analyze(process, &ctx, Analyzer::Buttons, buttons),
+            analyze(process, &ctx, Analyzer::Interfaces, interfaces),
+            analyze(process, &ctx, Analyzer::Offsets, offsets),
+            if streaming {
+                SchemaMap::default()
+            } else {
+                analyze(process, &ctx, Analyzer::Schemas, schemas)
+            },
+        )
+    };
+
+    let (class_count, enum_count, module_count) = match stream {
+        Some((memory_budget, sink)) => analyze(process, &ctx, Analyzer::Schemas, |process, ctx| {
+            stream_schemas(process, ctx, memory_budget, sink)
+        }),
+        None => (schemas.class_count(), schemas.enum_count(), schemas.len()),
+    };
+
+    info!("found {} buttons", buttons.len());
 
     info!(
         "found {} interfaces across {} modules",
@@ -40,8 +598,6 @@ pub fn analyze_all<P: Process + MemoryView>(process: &mut P) -> Result<AnalysisR
         interfaces.len()
     );
 
-    let offsets = analyze(process, offsets);
-
     info!(
         "found {} offsets across {} modules",
         offsets
@@ -51,39 +607,45 @@ pub fn analyze_all<P: Process + MemoryView>(process: &mut P) -> Result<AnalysisR
         offsets.len()
     );
 
-    let schemas = analyze(process, schemas);
+    info!(
+        "found {} classes and {} enums across {} modules",
+        class_count, enum_count, module_count
+    );
 
-    let (class_count, enum_count) =
-        schemas
-            .values()
-            .fold((0, 0), |(classes, enums), (class_vec, enum_vec)| {
-                (classes + class_vec.len(), enums + enum_vec.len())
-            });
+    let stats = ctx.cache.stats.lock().unwrap();
 
     info!(
-        "found {} classes and {} enums across {} modules",
-        class_count,
-        enum_count,
-        schemas.len()
+        "read {} bytes of module images in {:.2?}",
+        stats.bytes_read, stats.read_time
     );
 
     Ok(AnalysisResult {
         buttons,
+        filter: ctx.filter,
+        hints,
         interfaces,
         offsets,
         schemas,
     })
 }
 
-fn analyze<P, F, T>(process: &mut P, f: F) -> T
+fn analyze<P, F, T>(process: &mut P, ctx: &AnalysisContext, analyzer: Analyzer, f: F) -> T
 where
-    P: Process + MemoryView,
-    F: FnOnce(&mut P) -> Result<T>,
+    P: Target,
+    F: FnOnce(&mut P, &AnalysisContext) -> Result<T>,
     T: Default,
 {
+    if !ctx.filter.includes(analyzer) {
+        return T::default();
+    }
+
     let name = type_name::<F>();
 
-    match f(process) {
+    let _span = ctx.span("analyze", analyzer.name());
+
+    process.set_stage(analyzer.name());
+
+    match f(process, ctx) {
         Ok(result) => result,
         Err(err) => {
             error!("failed to read {}: {}", name, err);
@@ -92,3 +654,224 @@ where
         }
     }
 }
+
+fn spawn_analyzer<'scope, P, F, T>(
+    s: &'scope thread::Scope<'scope, '_>,
+    process: &P,
+    ctx: &'scope AnalysisContext,
+    analyzer: Analyzer,
+    f: F,
+) -> thread::ScopedJoinHandle<'scope, T>
+where
+    P: Target + Clone + Send + 'scope,
+    F: FnOnce(&mut P, &AnalysisContext) -> Result<T> + Send + 'scope,
+    T: Default + Send + 'scope,
+{
+    let mut process = process.clone();
+
+    s.spawn(move || analyze(&mut process, ctx, analyzer, f))
+}
+
+/// Maps `f` over `items` on up to `jobs` worker threads, each with its own process handle.
+///
+/// The results are returned in the same order as `items`, regardless of which worker produced
+/// them.
+fn par_map<P, I, T, F>(process: &mut P, jobs: usize, items: &[I], f: F) -> Vec<T>
+where
+    P: Target + Clone + Send,
+    I: Sync,
+    T: Send,
+    F: Fn(&mut P, &I) -> T + Sync,
+{
+    let workers = jobs.min(items.len());
+
+    if workers <= 1 {
+        return items.iter().map(|item| f(process, item)).collect();
+    }
+
+    let next = AtomicUsize::new(0);
+
+    let mut results: Vec<_> = thread::scope(|s| {
+        let handles: Vec<_> = (0..workers)
+            .map(|_| {
+                let mut process = process.clone();
+
+                let next = &next;
+                let f = &f;
+
+                s.spawn(move || {
+                    let mut results = Vec::new();
+
+                    loop {
+                        let i = next.fetch_add(1, Ordering::Relaxed);
+
+                        let Some(item) = items.get(i) else {
+                            break;
+                        };
+
+                        results.push((i, f(&mut process, item)));
+                    }
+
+                    results
+                })
+            })
+            .collect();
+
+        handles
+            .into_iter()
+            .flat_map(|handle| handle.join().unwrap())
+            .collect()
+    });
+
+    results.sort_unstable_by_key(|(i, _)| *i);
+
+    results.into_iter().map(|(_, result)| result).collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use crate::target::{Replay, Snapshot};
+
+    use super::*;
+
+    /// A context with a cold cache and no filter, for the benchmarks.
+    pub fn bench_context() -> AnalysisContext {
+        AnalysisContext {
+            baseline: None,
+            cache: ModuleCache::default(),
+            filter: Filter::default(),
+            hints: None,
+            metrics: None,
+            strings: StringCache::default(),
+            jobs: 1,
+        }
+    }
+
+    /// Runs a single analyzer against the benchmark snapshot, on a cold cache.
+    fn bench_analyzer<T>(
+        replay: &Replay,
+        name: &str,
+        f: impl FnOnce(&mut Replay, &AnalysisContext) -> Result<T>,
+        count: impl FnOnce(&T) -> usize,
+    ) -> Result<()> {
+        let mut replay = replay.clone();
+
+        let ctx = bench_context();
+
+        let batches = replay.batches();
+        let now = Instant::now();
+
+        let result = f(&mut replay, &ctx)?;
+
+        let elapsed = now.elapsed();
+
+        let stats = ctx.cache.stats.lock().unwrap();
+
+        println!(
+            "{}: {} items in {:.2?} ({:.2?} reading {} bytes of module images, {} read batches)",
+            name,
+            count(&result),
+            elapsed,
+            stats.read_time,
+            stats.bytes_read,
+            replay.batches() - batches
+        );
+
+        Ok(())
+    }
+
+    #[test]
+    #[ignore = "benchmark"]
+    fn analyze_snapshot() -> Result<()> {
+        let replay = Replay::open_bench()?;
+
+        bench_analyzer(&replay, "buttons", buttons, |buttons| buttons.len())?;
+
+        bench_analyzer(&replay, "interfaces", interfaces, |interfaces| {
+            interfaces.values().map(|ifaces| ifaces.len()).sum()
+        })?;
+
+        bench_analyzer(&replay, "offsets", offsets, |(offsets, _)| {
+            offsets.values().map(|offsets| offsets.len()).sum()
+        })?;
+
+        bench_analyzer(&replay, "schemas", schemas, |schemas| {
+            schemas.class_count() + schemas.enum_count()
+        })?;
+
+        let jobs = thread::available_parallelism().map_or(1, |jobs| jobs.get());
+
+        let batches = replay.batches();
+        let now = Instant::now();
+
+        analyze_all(
+            &mut replay.clone(),
+            jobs,
+            None,
+            Filter::default(),
+            None,
+            None,
+        )?;
+
+        println!(
+            "all ({} jobs): {:.2?} ({} read batches)",
+            jobs,
+            now.elapsed(),
+            replay.batches() - batches
+        );
+
+        Ok(())
+    }
+
+    #[test]
+    fn reused_analyzer_releases_expected_reads() -> Result<()> {
+        let mut replay = Replay::new(Snapshot::default(), Duration::ZERO);
+
+        let ctx = AnalysisContext {
+            baseline: Some(Baseline {
+                modules: BTreeSet::from(["client.dll".to_string()]),
+                buttons: Some(ButtonMap::from([("attack".to_string(), 0x10)])),
+                ..Default::default()
+            }),
+            ..bench_context()
+        };
+
+        ctx.cache.expect("client.dll", ImageParts::CODE);
+        ctx.cache.expect("client.dll", ImageParts::EXPORTS);
+
+        assert_eq!(buttons(&mut replay, &ctx)?.len(), 1);
+
+        // Only the read of the exports is still expected, so nothing else is read along with it.
+        {
+            let entries = ctx.cache.entries.lock().unwrap();
+
+            assert_eq!(entries["client.dll"].readers, [ImageParts::EXPORTS]);
+        }
+
+        ctx.cache.release("client.dll", ImageParts::EXPORTS);
+
+        assert!(ctx.cache.entries.lock().unwrap().is_empty());
+
+        Ok(())
+    }
+
+    #[test]
+    fn missing_runs_merges_and_skips_pages() {
+        let len = 5 * PAGE_LEN + 0x10;
+        let mut pages = vec![false; len.div_ceil(PAGE_LEN)];
+
+        // The headers, plus two adjacent sections that share a page.
+        let runs = missing_runs(len, &mut pages, [0..0x400, 0x1000..0x1800, 0x1800..0x2100]);
+
+        assert_eq!(runs, [0..0x3000]);
+
+        // Pages that were read already are skipped, and the last page is cut off at the end of
+        // the image.
+        let runs = missing_runs(len, &mut pages, [0x2000..0x2010, 0x4ff0..0x9000]);
+
+        assert_eq!(runs, [0x4000..len]);
+        assert_eq!(pages, [true, true, true, false, true, true]);
+
+        assert!(missing_runs(len, &mut pages, [0x10..0x20, 0x8000..0x9000]).is_empty());
+    }
+}
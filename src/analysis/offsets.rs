@@ -1,59 +1,150 @@
 use std::collections::BTreeMap;
+use std::iter;
 
 use anyhow::Result;
 
-use log::{debug, error};
+use log::{debug, error, info};
 
 use memflow::prelude::v1::*;
 
 use pelite::pattern;
-use pelite::pattern::{Atom, save_len};
+use pelite::pattern::Atom;
 use pelite::pe64::{Pe, PeView, Rva};
 
 use phf::{Map, phf_map};
 
+use super::{AnalysisContext, Analyzer, ImageParts, par_map, scanner};
+
+use crate::target::Target;
+
 pub type OffsetMap = BTreeMap<String, BTreeMap<String, Rva>>;
 
+/// The RVA of the code every pattern matched at, by module and offset name. The next run searches
+/// for each pattern around it first.
+pub type HintMap = BTreeMap<String, BTreeMap<String, Rva>>;
+
+/// The offsets found in a single module.
+#[derive(Debug, Default)]
+pub struct ModuleOffsets {
+    pub offsets: BTreeMap<String, Rva>,
+
+    /// Where each of the patterns matched, see [`HintMap`].
+    pub locations: BTreeMap<String, Rva>,
+
+    /// The number of patterns that were found near their hint.
+    pub hinted: usize,
+}
+
+impl ModuleOffsets {
+    fn record(&mut self, name: &str, found: &scanner::Match) {
+        debug!(
+            "found pattern: {} at {:#X} ({})",
+            name,
+            found.save[0],
+            if found.hinted {
+                "near its hint"
+            } else {
+                "by a full scan"
+            }
+        );
+
+        self.locations.insert(name.to_string(), found.save[0]);
+
+        if found.hinted {
+            self.hinted += 1;
+        }
+    }
+}
+
 macro_rules! pattern_map {
     ($($module:ident => {
-        $($name:expr => $pattern:expr $(=> $callback:expr)?),+ $(,)?
+        $($name:expr => $pattern:expr $(=> {
+            $($sub_name:expr => $sub_pattern:expr),+ $(,)?
+        })?),+ $(,)?
     }),+ $(,)?) => {
         $(
             mod $module {
                 use super::*;
 
+                /// Each pattern can carry sub-patterns, whose saved value is added to the value of
+                /// the pattern itself.
                 pub(super) const PATTERNS: Map<
                     &'static str,
-                    (
-                        &'static [Atom],
-                        Option<fn(&PeView, &mut BTreeMap<String, Rva>, Rva)>,
-                    ),
+                    (&'static [Atom], &'static [(&'static str, &'static [Atom])]),
                 > = phf_map! {
-                    $($name => ($pattern, $($callback)?)),+
+                    $($name => ($pattern, &[$($(($sub_name, $sub_pattern)),+)?])),+
                 };
 
-                pub fn offsets(view: PeView<'_>) -> BTreeMap<String, Rva> {
-                    let mut map = BTreeMap::new();
-
-                    for (&name, (pat, callback)) in &PATTERNS {
-                        let mut save = vec![0; save_len(pat)];
-
-                        if !view.scanner().finds_code(pat, &mut save) {
+                /// Only the offsets for which `include` returns `true` are resolved. A pattern is
+                /// still scanned for if just one of its sub-patterns is included. Patterns with an
+                /// entry in `hints` are searched for around it first.
+                pub fn offsets(
+                    view: PeView<'_>,
+                    include: &dyn Fn(&str) -> bool,
+                    hints: &BTreeMap<String, Rva>,
+                ) -> ModuleOffsets {
+                    let mut found = ModuleOffsets::default();
+
+                    let selected: Vec<_> = PATTERNS
+                        .entries()
+                        .filter_map(|(&name, (pat, sub_patterns))| {
+                            let sub_patterns: Vec<_> = sub_patterns
+                                .iter()
+                                .filter(|(sub_name, _)| include(sub_name))
+                                .collect();
+
+                            (include(name) || !sub_patterns.is_empty())
+                                .then_some((name, *pat, sub_patterns))
+                        })
+                        .collect();
+
+                    // Resolve all selected patterns and sub-patterns in a single pass over the
+                    // code.
+                    let (patterns, pattern_hints): (Vec<_>, Vec<_>) = selected
+                        .iter()
+                        .flat_map(|(name, pat, sub_patterns)| {
+                            iter::once((*name, *pat))
+                                .chain(sub_patterns.iter().map(|(name, pat)| (*name, *pat)))
+                        })
+                        .map(|(name, pat)| (pat, hints.get(name).copied()))
+                        .unzip();
+
+                    let mut matches =
+                        scanner::find_unique(view, &patterns, &pattern_hints).into_iter();
+
+                    for (name, _, sub_patterns) in &selected {
+                        let m = matches.next().flatten();
+                        let sub_matches: Vec<_> =
+                            matches.by_ref().take(sub_patterns.len()).collect();
+
+                        let Some(m) = m else {
                             error!("outdated pattern: {}", name);
 
                             continue;
-                        }
+                        };
 
-                        let rva = save[1];
+                        found.record(name, &m);
 
-                        map.insert(name.to_string(), rva);
+                        let rva = m.save[1];
 
-                        if let Some(callback) = callback {
-                            callback(&view, &mut map, rva);
+                        if include(name) {
+                            found.offsets.insert(name.to_string(), rva);
+                        }
+
+                        for ((sub_name, _), sub_match) in sub_patterns.iter().zip(sub_matches) {
+                            match sub_match {
+                                Some(sub_match) => {
+                                    found.record(sub_name, &sub_match);
+                                    found
+                                        .offsets
+                                        .insert(sub_name.to_string(), rva + sub_match.save[1]);
+                                }
+                                None => error!("outdated pattern: {}", sub_name),
+                            }
                         }
                     }
 
-                    for (name, value) in &map {
+                    for (name, value) in &found.offsets {
                         debug!(
                             "found offset: {} at {:#X} ({}.dll + {:#X})",
                             name,
@@ -63,7 +154,7 @@ macro_rules! pattern_map {
                         );
                     }
 
-                    map
+                    found
                 }
             }
         )+
@@ -72,83 +163,137 @@ macro_rules! pattern_map {
 
 pattern_map! {
     client => {
-        "dwCSGOInput" => pattern!("488905${'} 0f57c0 0f1105") => Some(|view, map, rva| {
-            let mut save = [0; 2];
-
-            if view.scanner().finds_code(pattern!("f2420f108428u4"), &mut save) {
-                map.insert("dwViewAngles".to_string(), rva + save[1]);
-            }
-        }),
-        "dwEntityList" => pattern!("48890d${'} e9${} cc") => None,
-        "dwGameEntitySystem" => pattern!("488b1d${'} 48891d[4] 4c63b3") => None,
-        "dwGameEntitySystem_highestEntityIndex" => pattern!("ff81u4 4885d2") => None,
-        "dwGameRules" => pattern!("48891d${'} ff15${} 84c0") => None,
-        "dwGlobalVars" => pattern!("488915${'} 488942") => None,
-        "dwGlowManager" => pattern!("488b05${'} c3 cccccccccccccccc 8b41") => None,
-        "dwLocalPlayerController" => pattern!("488b05${'} 4189be") => None,
-        "dwPlantedC4" => pattern!("488b15${'} 41ffc0 488d4c24? 448905[4]") => None,
-        "dwPrediction" => pattern!("488d05${'} c3 cccccccccccccccc 405356 4154") => Some(|view, map, rva| {
-            let mut save = [0; 2];
-
-            if view.scanner().finds_code(pattern!("4c39b6u4 74? 4488be"), &mut save) {
-                map.insert("dwLocalPlayerPawn".to_string(), rva + save[1]);
-            }
-        }),
-        "dwSensitivity" => pattern!("488d0d${[8]'} 660f6ecd") => None,
-        "dwSensitivity_sensitivity" => pattern!("488d7eu1 480fbae0? 72? 85d2 490f4fff") => None,
-        "dwViewMatrix" => pattern!("488d0d${'} 48c1e006") => None,
-        "dwViewRender" => pattern!("488905${'} 488bc8 4885c0") => None,
-        "dwWeaponC4" => pattern!("488b15${'} 488b5c24? ffc0 8905${} 488bc6 488934ea 80be") => None,
+        "dwCSGOInput" => pattern!("488905${'} 0f57c0 0f1105") => {
+            "dwViewAngles" => pattern!("f2420f108428u4"),
+        },
+        "dwEntityList" => pattern!("48890d${'} e9${} cc"),
+        "dwGameEntitySystem" => pattern!("488b1d${'} 48891d[4] 4c63b3"),
+        "dwGameEntitySystem_highestEntityIndex" => pattern!("ff81u4 4885d2"),
+        "dwGameRules" => pattern!("48891d${'} ff15${} 84c0"),
+        "dwGlobalVars" => pattern!("488915${'} 488942"),
+        "dwGlowManager" => pattern!("488b05${'} c3 cccccccccccccccc 8b41"),
+        "dwLocalPlayerController" => pattern!("488b05${'} 4189be"),
+        "dwPlantedC4" => pattern!("488b15${'} 41ffc0 488d4c24? 448905[4]"),
+        "dwPrediction" => pattern!("488d05${'} c3 cccccccccccccccc 405356 4154") => {
+            "dwLocalPlayerPawn" => pattern!("4c39b6u4 74? 4488be"),
+        },
+        "dwSensitivity" => pattern!("488d0d${[8]'} 660f6ecd"),
+        "dwSensitivity_sensitivity" => pattern!("488d7eu1 480fbae0? 72? 85d2 490f4fff"),
+        "dwViewMatrix" => pattern!("488d0d${'} 48c1e006"),
+        "dwViewRender" => pattern!("488905${'} 488bc8 4885c0"),
+        "dwWeaponC4" => pattern!("488b15${'} 488b5c24? ffc0 8905${} 488bc6 488934ea 80be"),
     },
     engine2 => {
-        "dwBuildNumber" => pattern!("8905${'} 488d0d${} ff15${} 488b0d") => None,
-        "dwNetworkGameClient" => pattern!("48893d${'} ff87") => None,
-        "dwNetworkGameClient_clientTickCount" => pattern!("8b81u4 c3 cccccccccccccccccc 8b81${} c3 cccccccccccccccccc 83b9") => None,
-        "dwNetworkGameClient_deltaTick" => pattern!("4c8db7u4 4c897c24") => None,
-        "dwNetworkGameClient_isBackgroundMap" => pattern!("0fb681u4 c3 cccccccccccccccc 0fb681${} c3 cccccccccccccccc 4053") => None,
-        "dwNetworkGameClient_localPlayer" => pattern!("428b94d3u4 5b 49ffe3 32c0 5b c3 cccccccccccccccc 4053") => None,
-        "dwNetworkGameClient_maxClients" => pattern!("8b81u4 c3????????? 8b81[4] c3????????? 8b81") => None,
-        "dwNetworkGameClient_serverTickCount" => pattern!("8b81u4 c3 cccccccccccccccccc 83b9") => None,
-        "dwNetworkGameClient_signOnState" => pattern!("448b81u4 488d0d") => None,
-        "dwWindowHeight" => pattern!("8b05${'} 8903") => None,
-        "dwWindowWidth" => pattern!("8b05${'} 8907") => None,
+        "dwBuildNumber" => pattern!("8905${'} 488d0d${} ff15${} 488b0d"),
+        "dwNetworkGameClient" => pattern!("48893d${'} ff87"),
+        "dwNetworkGameClient_clientTickCount" => pattern!("8b81u4 c3 cccccccccccccccccc 8b81${} c3 cccccccccccccccccc 83b9"),
+        "dwNetworkGameClient_deltaTick" => pattern!("4c8db7u4 4c897c24"),
+        "dwNetworkGameClient_isBackgroundMap" => pattern!("0fb681u4 c3 cccccccccccccccc 0fb681${} c3 cccccccccccccccc 4053"),
+        "dwNetworkGameClient_localPlayer" => pattern!("428b94d3u4 5b 49ffe3 32c0 5b c3 cccccccccccccccc 4053"),
+        "dwNetworkGameClient_maxClients" => pattern!("8b81u4 c3????????? 8b81[4] c3????????? 8b81"),
+        "dwNetworkGameClient_serverTickCount" => pattern!("8b81u4 c3 cccccccccccccccccc 83b9"),
+        "dwNetworkGameClient_signOnState" => pattern!("448b81u4 488d0d"),
+        "dwWindowHeight" => pattern!("8b05${'} 8903"),
+        "dwWindowWidth" => pattern!("8b05${'} 8907"),
     },
     input_system => {
-        "dwInputSystem" => pattern!("488905${'} 33c0") => None,
+        "dwInputSystem" => pattern!("488905${'} 33c0"),
     },
     matchmaking => {
-        "dwGameTypes" => pattern!("488d0d${'} ff90") => None,
+        "dwGameTypes" => pattern!("488d0d${'} ff90"),
     },
     soundsystem => {
-        "dwSoundSystem" => pattern!("488d05${'} c3 cccccccccccccccc 488915") => None,
-        "dwSoundSystem_engineViewData" => pattern!("0f1147u1 0f104e? 0f118f") => None,
+        "dwSoundSystem" => pattern!("488d05${'} c3 cccccccccccccccc 488915"),
+        "dwSoundSystem_engineViewData" => pattern!("0f1147u1 0f104e? 0f118f"),
     },
 }
 
-pub fn offsets<P: Process + MemoryView>(process: &mut P) -> Result<OffsetMap> {
-    let mut map = BTreeMap::new();
+type OffsetsFn = fn(PeView, &dyn Fn(&str) -> bool, &BTreeMap<String, Rva>) -> ModuleOffsets;
+
+pub const OFFSET_MODULES: &[(&str, OffsetsFn)] = &[
+    ("client.dll", client::offsets),
+    ("engine2.dll", engine2::offsets),
+    ("inputsystem.dll", input_system::offsets),
+    ("matchmaking.dll", matchmaking::offsets),
+    ("soundsystem.dll", soundsystem::offsets),
+];
+
+/// Returns the offsets of every module, and the [`HintMap`] for the next run if hints are
+/// enabled.
+pub fn offsets<P>(process: &mut P, ctx: &AnalysisContext) -> Result<(OffsetMap, HintMap)>
+where
+    P: Target + Clone + Send,
+{
+    let modules: Vec<_> = OFFSET_MODULES
+        .iter()
+        .filter(|(module_name, _)| ctx.filter.includes_module(Analyzer::Offsets, module_name))
+        .collect();
+
+    let results = par_map(
+        process,
+        ctx.jobs,
+        &modules,
+        |process, (module_name, offsets)| -> Result<_> {
+            let hints = ctx
+                .hints
+                .as_ref()
+                .and_then(|hints| hints.get(*module_name))
+                .cloned()
+                .unwrap_or_default();
+
+            if let Some(offsets) = ctx.reuse(module_name, |baseline| {
+                baseline.offsets.as_ref()?.get(*module_name).cloned()
+            }) {
+                ctx.cache.release(module_name, ImageParts::CODE);
+
+                return Ok((module_name.to_string(), offsets, hints));
+            }
+
+            let image = ctx
+                .cache
+                .image_by_name(process, module_name, ImageParts::CODE)?;
 
-    let modules: [(&str, fn(PeView) -> BTreeMap<String, u32>); 5] = [
-        ("client.dll", client::offsets),
-        ("engine2.dll", engine2::offsets),
-        ("inputsystem.dll", input_system::offsets),
-        ("matchmaking.dll", matchmaking::offsets),
-        ("soundsystem.dll", soundsystem::offsets),
-    ];
+            let include = |name: &str| {
+                ctx.filter
+                    .includes_name(Analyzer::Offsets, module_name, name)
+            };
 
-    for (module_name, offsets) in &modules {
-        let module = process.module_by_name(module_name)?;
+            let _span = ctx.span("scan", *module_name);
 
-        let buf = process
-            .read_raw(module.base, module.size as _)
-            .data_part()?;
+            let found = offsets(image.view()?, &include, &hints);
 
-        let view = PeView::from_bytes(&buf)?;
+            if !hints.is_empty() {
+                info!(
+                    "found {} of {} patterns in {} near their previous location",
+                    found.hinted,
+                    found.locations.len(),
+                    module_name
+                );
+            }
+
+            // Patterns that were filtered out keep their previous location.
+            let mut locations = hints;
+
+            locations.extend(found.locations);
+
+            Ok((module_name.to_string(), found.offsets, locations))
+        },
+    );
+
+    let mut offset_map = OffsetMap::new();
+    let mut hint_map = HintMap::new();
+
+    for result in results {
+        let (module_name, offsets, locations) = result?;
+
+        if ctx.hints.is_some() {
+            hint_map.insert(module_name.clone(), locations);
+        }
 
-        map.insert(module_name.to_string(), offsets(view));
+        offset_map.insert(module_name, offsets);
     }
 
-    Ok(map)
+    Ok((offset_map, hint_map))
 }
 
 #[cfg(test)]
@@ -0,0 +1,215 @@
+use std::collections::BTreeMap;
+
+use aho_corasick::AhoCorasick;
+
+use pelite::image::IMAGE_SCN_MEM_EXECUTE;
+use pelite::pattern::{Atom, save_len};
+use pelite::pe64::{Pe, Rva};
+
+/// How far from its hint a pattern is searched for first, in bytes either way.
+const HINT_WINDOW: Rva = 0x40000;
+
+enum Found {
+    None,
+    Unique(Vec<Rva>),
+    Multiple,
+}
+
+/// A resolved pattern.
+pub struct Match {
+    /// The saved values, the first of which is the RVA the pattern matched at.
+    pub save: Vec<Rva>,
+
+    /// Whether the pattern was found near its hint, rather than by a scan of the whole image.
+    pub hinted: bool,
+}
+
+/// Resolves every pattern against the executable sections of an image.
+///
+/// Patterns with a hint, typically the RVA they matched at in the previous build, are searched for
+/// around it first. The remaining patterns are resolved in a single pass over the image, see
+/// [`scan`]. The results are returned in the same order as `patterns`.
+pub fn find_unique<'a>(
+    pe: impl Pe<'a>,
+    patterns: &[&[Atom]],
+    hints: &[Option<Rva>],
+) -> Vec<Option<Match>> {
+    let mut found: Vec<_> = patterns
+        .iter()
+        .zip(hints)
+        .map(|(pat, hint)| {
+            hint.and_then(|hint| find_near(pe, pat, hint))
+                .map(|save| Match { save, hinted: true })
+        })
+        .collect();
+
+    let missed: Vec<_> = (0..patterns.len())
+        .filter(|&i| found[i].is_none())
+        .collect();
+
+    if missed.is_empty() {
+        return found;
+    }
+
+    let missed_patterns: Vec<_> = missed.iter().map(|&i| patterns[i]).collect();
+
+    for (i, save) in missed.into_iter().zip(scan(pe, &missed_patterns)) {
+        found[i] = save.map(|save| Match {
+            save,
+            hinted: false,
+        });
+    }
+
+    found
+}
+
+/// Looks for a pattern within [`HINT_WINDOW`] of `hint`, in the executable section that contains
+/// it. Unless the pattern still matches at the hint itself, it has to match exactly once in the
+/// window to count as found.
+fn find_near<'a>(pe: impl Pe<'a>, pat: &[Atom], hint: Rva) -> Option<Vec<Rva>> {
+    let scanner = pe.scanner();
+
+    let mut save = vec![0; save_len(pat)];
+
+    // Most code doesn't move at all between two builds.
+    if scanner.exec(hint, pat, &mut save) {
+        return Some(save);
+    }
+
+    let section = pe.section_headers().iter().find(|section| {
+        section.Characteristics & IMAGE_SCN_MEM_EXECUTE != 0
+            && (section.VirtualAddress..section.VirtualAddress + section.VirtualSize)
+                .contains(&hint)
+    })?;
+
+    let bytes = pe.get_section_bytes(section).ok()?;
+
+    let start = hint.saturating_sub(HINT_WINDOW).max(section.VirtualAddress);
+    let end = hint
+        .saturating_add(HINT_WINDOW)
+        .min(section.VirtualAddress + bytes.len() as Rva);
+
+    let window = bytes
+        .get((start - section.VirtualAddress) as usize..(end - section.VirtualAddress) as usize)?;
+
+    let prefix = literal_prefix(pat);
+
+    let ac = AhoCorasick::new([&prefix]).ok()?;
+
+    let candidates: Box<dyn Iterator<Item = usize>> = if prefix.is_empty() {
+        Box::new(0..window.len())
+    } else {
+        Box::new(ac.find_overlapping_iter(window).map(|m| m.start()))
+    };
+
+    let mut found = None;
+
+    for offset in candidates {
+        if !scanner.exec(start + offset as Rva, pat, &mut save) {
+            continue;
+        }
+
+        if found.is_some() {
+            return None;
+        }
+
+        found = Some(save.clone());
+    }
+
+    found
+}
+
+/// Resolves every pattern against the executable sections of an image in a single pass.
+///
+/// The leading literal bytes of all patterns are compiled into one Aho-Corasick automaton, and
+/// each of its hits is verified by running the complete pattern at that position. Patterns without
+/// a literal prefix fall back to a dedicated scan.
+///
+/// Like `Scanner::finds_code`, a pattern only resolves if it matches exactly once.
+fn scan<'a>(pe: impl Pe<'a>, patterns: &[&[Atom]]) -> Vec<Option<Vec<Rva>>> {
+    let scanner = pe.scanner();
+
+    let mut found: Vec<_> = patterns.iter().map(|_| Found::None).collect();
+
+    // Patterns sharing the same prefix are verified off the same hit.
+    let mut groups = BTreeMap::<Vec<u8>, Vec<usize>>::new();
+
+    for (i, pat) in patterns.iter().enumerate() {
+        let prefix = literal_prefix(pat);
+
+        if prefix.is_empty() {
+            let mut save = vec![0; save_len(pat)];
+
+            if scanner.finds_code(pat, &mut save) {
+                found[i] = Found::Unique(save);
+            }
+
+            continue;
+        }
+
+        groups.entry(prefix).or_default().push(i);
+    }
+
+    let (prefixes, groups): (Vec<_>, Vec<_>) = groups.into_iter().unzip();
+
+    let Ok(ac) = AhoCorasick::new(&prefixes) else {
+        return finish(found);
+    };
+
+    let sections = pe
+        .section_headers()
+        .iter()
+        .filter(|section| section.Characteristics & IMAGE_SCN_MEM_EXECUTE != 0);
+
+    for section in sections {
+        let Ok(bytes) = pe.get_section_bytes(section) else {
+            continue;
+        };
+
+        for m in ac.find_overlapping_iter(bytes) {
+            let cursor = section.VirtualAddress + m.start() as Rva;
+
+            for &i in &groups[m.pattern().as_usize()] {
+                if matches!(found[i], Found::Multiple) {
+                    continue;
+                }
+
+                let pat = patterns[i];
+
+                let mut save = vec![0; save_len(pat)];
+
+                if !scanner.exec(cursor, pat, &mut save) {
+                    continue;
+                }
+
+                found[i] = match found[i] {
+                    Found::None => Found::Unique(save),
+                    _ => Found::Multiple,
+                };
+            }
+        }
+    }
+
+    finish(found)
+}
+
+fn finish(found: Vec<Found>) -> Vec<Option<Vec<Rva>>> {
+    found
+        .into_iter()
+        .map(|found| match found {
+            Found::Unique(save) => Some(save),
+            _ => None,
+        })
+        .collect()
+}
+
+/// Returns the literal bytes a pattern must start with, skipping the leading save atoms.
+fn literal_prefix(pat: &[Atom]) -> Vec<u8> {
+    pat.iter()
+        .skip_while(|atom| matches!(atom, Atom::Save(_)))
+        .map_while(|atom| match atom {
+            Atom::Byte(byte) => Some(*byte),
+            _ => None,
+        })
+        .collect()
+}
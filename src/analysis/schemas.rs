@@ -1,47 +1,112 @@
-use std::collections::BTreeMap;
+use std::collections::{BTreeMap, HashMap, HashSet};
 use std::ffi::CStr;
+use std::ops::Range;
+use std::ptr;
+use std::sync::Arc;
 
 use anyhow::{Result, bail};
 
-use log::debug;
+use log::{debug, warn};
 
 use memflow::prelude::v1::*;
 
 use pelite::pattern;
-use pelite::pe64::{Pe, PeView};
+use pelite::pe64::Pe;
 
 use serde::{Deserialize, Serialize};
 
-use crate::source2::*;
+use super::{AnalysisContext, Analyzer, ImageParts, SchemaSink, StringCache, par_map};
 
-pub type SchemaMap = BTreeMap<String, (Vec<Class>, Vec<Enum>)>;
+use crate::metrics;
+use crate::source2::*;
+use crate::target::Target;
 
 #[derive(Clone, Debug, Deserialize, Serialize)]
 pub enum ClassMetadata {
-    Unknown { name: String },
-    NetworkChangeCallback { name: String },
-    NetworkVarNames { name: String, type_name: String },
+    Unknown { name: Arc<str> },
+    NetworkChangeCallback { name: Arc<str> },
+    NetworkVarNames { name: Arc<str>, type_name: Arc<str> },
 }
 
 #[derive(Clone, Debug, Deserialize, Serialize)]
 pub struct Class {
-    pub name: String,
-    pub module_name: String,
+    pub name: Arc<str>,
+    pub module_name: Arc<str>,
     pub parent: Option<Box<Class>>,
+
+    /// The alignment of the class in bytes, or 0 if it isn't known.
+    pub alignment: u8,
+
+    /// The size of the class in bytes, including any tail padding, or 0 if it isn't known.
+    pub size: i32,
+
     pub metadata: Vec<ClassMetadata>,
     pub fields: Vec<ClassField>,
 }
 
+/// Builds classes for test fixtures. Anything not set is left empty, and a parent only carries its
+/// name, like one that is resolved within the module of its child.
+#[cfg(test)]
+impl Class {
+    pub(crate) fn new(module_name: &str, name: &str) -> Self {
+        Self {
+            name: Arc::from(name),
+            module_name: Arc::from(module_name),
+            parent: None,
+            alignment: 0,
+            size: 0,
+            metadata: Vec::new(),
+            fields: Vec::new(),
+        }
+    }
+
+    pub(crate) fn with_parent(mut self, parent: Option<&str>) -> Self {
+        self.parent = parent.map(|name| Box::new(Class::new("", name)));
+
+        self
+    }
+
+    pub(crate) fn with_layout(mut self, alignment: u8, size: i32) -> Self {
+        self.alignment = alignment;
+        self.size = size;
+
+        self
+    }
+
+    pub(crate) fn with_metadata(mut self, metadata: Vec<ClassMetadata>) -> Self {
+        self.metadata = metadata;
+
+        self
+    }
+
+    /// Sets the fields from `(name, type name, offset)` tuples.
+    pub(crate) fn with_fields<'a>(
+        mut self,
+        fields: impl IntoIterator<Item = (&'a str, &'a str, i32)>,
+    ) -> Self {
+        self.fields = fields
+            .into_iter()
+            .map(|(name, type_name, offset)| ClassField {
+                name: Arc::from(name),
+                type_name: Arc::from(type_name),
+                offset,
+            })
+            .collect();
+
+        self
+    }
+}
+
 #[derive(Clone, Debug, Deserialize, Serialize)]
 pub struct ClassField {
-    pub name: String,
-    pub type_name: String,
+    pub name: Arc<str>,
+    pub type_name: Arc<str>,
     pub offset: i32,
 }
 
 #[derive(Clone, Debug, Deserialize, Serialize)]
 pub struct Enum {
-    pub name: String,
+    pub name: Arc<str>,
     pub alignment: u8,
     pub size: u16,
     pub members: Vec<EnumMember>,
@@ -49,7 +114,7 @@ pub struct Enum {
 
 #[derive(Clone, Debug, Deserialize, Serialize)]
 pub struct EnumMember {
-    pub name: String,
+    pub name: Arc<str>,
     pub value: i64,
 }
 
@@ -60,11 +125,683 @@ pub struct TypeScope {
     pub enums: Vec<Enum>,
 }
 
-pub fn schemas<P: Process + MemoryView>(process: &mut P) -> Result<SchemaMap> {
-    let schema_system = read_schema_system(process)?;
-    let type_scopes = read_type_scopes(process, &schema_system)?;
+/// The classes and enums of every schema module, stored in flat arrays.
+///
+/// All strings live in a single arena, and the fields, metadata and members of every class and
+/// enum are stored contiguously and referred to by range, so the number of allocations doesn't
+/// depend on the number of classes. Parents are resolved to classes when the map is built.
+///
+/// The contents are accessed through borrowed views, starting at [`SchemaMap::modules`].
+#[derive(Debug, Default)]
+pub struct SchemaMap {
+    strings: String,
+    modules: Vec<ModuleRecord>,
+    classes: Vec<ClassRecord>,
+    fields: Vec<FieldRecord>,
+    metadata: Vec<MetadataRecord>,
+    enums: Vec<EnumRecord>,
+    members: Vec<MemberRecord>,
+}
+
+/// A string in the arena of a [`SchemaMap`].
+#[derive(Clone, Copy, Debug)]
+struct Str {
+    start: u32,
+    len: u32,
+}
+
+/// A range of records in one of the arrays of a [`SchemaMap`].
+#[derive(Clone, Copy, Debug)]
+struct Span {
+    start: u32,
+    end: u32,
+}
+
+impl Span {
+    #[inline]
+    fn range(self) -> Range<usize> {
+        self.start as usize..self.end as usize
+    }
+}
+
+#[derive(Debug)]
+struct ModuleRecord {
+    name: Str,
+    classes: Span,
+    enums: Span,
+}
+
+#[derive(Debug)]
+enum ParentRecord {
+    None,
+    Class(u32),
+
+    /// A parent that isn't part of the map, e.g. because its type scope was reused from a
+    /// previous run.
+    Name(Str),
+}
+
+#[derive(Debug)]
+struct ClassRecord {
+    name: Str,
+    module_name: Str,
+    parent: ParentRecord,
+    alignment: u8,
+    size: i32,
+    fields: Span,
+    metadata: Span,
+}
+
+#[derive(Debug)]
+struct FieldRecord {
+    name: Str,
+    type_name: Str,
+    offset: i32,
+}
+
+#[derive(Debug)]
+enum MetadataRecord {
+    Unknown { name: Str },
+    NetworkChangeCallback { name: Str },
+    NetworkVarNames { name: Str, type_name: Str },
+}
+
+#[derive(Debug)]
+struct EnumRecord {
+    name: Str,
+    alignment: u8,
+    size: u16,
+    members: Span,
+}
+
+#[derive(Debug)]
+struct MemberRecord {
+    name: Str,
+    value: i64,
+}
+
+impl SchemaMap {
+    #[inline]
+    pub fn class_count(&self) -> usize {
+        self.classes.len()
+    }
+
+    #[inline]
+    pub fn enum_count(&self) -> usize {
+        self.enums.len()
+    }
+
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.modules.is_empty()
+    }
+
+    /// Returns the number of modules.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.modules.len()
+    }
+
+    /// Returns the schema modules sorted by name.
+    pub fn modules(&self) -> impl ExactSizeIterator<Item = ModuleView<'_>> {
+        self.modules.iter().map(|record| ModuleView {
+            name: self.str(record.name),
+            map: self,
+            record,
+        })
+    }
+
+    pub fn module(&self, name: &str) -> Option<ModuleView<'_>> {
+        let i = self
+            .modules
+            .binary_search_by(|record| self.str(record.name).cmp(name))
+            .ok()?;
+
+        self.modules().nth(i)
+    }
+
+    #[inline]
+    fn str(&self, s: Str) -> &str {
+        &self.strings[s.start as usize..(s.start + s.len) as usize]
+    }
+
+    fn class(&self, id: u32) -> ClassView<'_> {
+        let record = &self.classes[id as usize];
+
+        let parent = match record.parent {
+            ParentRecord::None => None,
+            ParentRecord::Class(parent_id) => Some(self.str(self.classes[parent_id as usize].name)),
+            ParentRecord::Name(name) => Some(self.str(name)),
+        };
+
+        ClassView {
+            name: self.str(record.name),
+            module_name: self.str(record.module_name),
+            parent,
+            alignment: record.alignment,
+            size: record.size,
+            map: self,
+            id,
+        }
+    }
+}
+
+/// Builds a map from the classes and enums of each type scope. Like the map of a type scope name
+/// to its contents, a later type scope replaces an earlier one with the same name.
+impl FromIterator<(String, (Vec<Class>, Vec<Enum>))> for SchemaMap {
+    fn from_iter<I>(iter: I) -> Self
+    where
+        I: IntoIterator<Item = (String, (Vec<Class>, Vec<Enum>))>,
+    {
+        let scopes: BTreeMap<_, _> = iter.into_iter().collect();
+
+        let mut builder = SchemaMapBuilder::default();
+
+        for (module_name, (classes, enums)) in &scopes {
+            builder.push_module(module_name, classes, enums);
+        }
+
+        builder.resolve_parents(&scopes);
+
+        builder.map
+    }
+}
+
+#[derive(Default)]
+struct SchemaMapBuilder<'a> {
+    map: SchemaMap,
+    interned: HashMap<&'a str, Str>,
+}
+
+impl<'a> SchemaMapBuilder<'a> {
+    fn str(&mut self, s: &'a str) -> Str {
+        if let Some(&s) = self.interned.get(s) {
+            return s;
+        }
+
+        let str = Str {
+            start: self.map.strings.len() as u32,
+            len: s.len() as u32,
+        };
+
+        self.map.strings.push_str(s);
+        self.interned.insert(s, str);
+
+        str
+    }
+
+    fn push_module(&mut self, name: &'a str, classes: &'a [Class], enums: &'a [Enum]) {
+        let name = self.str(name);
+
+        let first_class = self.map.classes.len() as u32;
+
+        for class in classes {
+            let name = self.str(&class.name);
+            let module_name = self.str(&class.module_name);
+
+            let first_field = self.map.fields.len() as u32;
+
+            for field in &class.fields {
+                let record = FieldRecord {
+                    name: self.str(&field.name),
+                    type_name: self.str(&field.type_name),
+                    offset: field.offset,
+                };
+
+                self.map.fields.push(record);
+            }
+
+            let first_metadata = self.map.metadata.len() as u32;
+
+            for metadata in &class.metadata {
+                let record = match metadata {
+                    ClassMetadata::Unknown { name } => MetadataRecord::Unknown {
+                        name: self.str(name),
+                    },
+                    ClassMetadata::NetworkChangeCallback { name } => {
+                        MetadataRecord::NetworkChangeCallback {
+                            name: self.str(name),
+                        }
+                    }
+                    ClassMetadata::NetworkVarNames { name, type_name } => {
+                        MetadataRecord::NetworkVarNames {
+                            name: self.str(name),
+                            type_name: self.str(type_name),
+                        }
+                    }
+                };
+
+                self.map.metadata.push(record);
+            }
+
+            self.map.classes.push(ClassRecord {
+                name,
+                module_name,
+                parent: ParentRecord::None,
+                alignment: class.alignment,
+                size: class.size,
+                fields: Span {
+                    start: first_field,
+                    end: self.map.fields.len() as u32,
+                },
+                metadata: Span {
+                    start: first_metadata,
+                    end: self.map.metadata.len() as u32,
+                },
+            });
+        }
+
+        let first_enum = self.map.enums.len() as u32;
+
+        for enum_ in enums {
+            let name = self.str(&enum_.name);
+
+            let first_member = self.map.members.len() as u32;
+
+            for member in &enum_.members {
+                let record = MemberRecord {
+                    name: self.str(&member.name),
+                    value: member.value,
+                };
+
+                self.map.members.push(record);
+            }
+
+            self.map.enums.push(EnumRecord {
+                name,
+                alignment: enum_.alignment,
+                size: enum_.size,
+                members: Span {
+                    start: first_member,
+                    end: self.map.members.len() as u32,
+                },
+            });
+        }
+
+        self.map.modules.push(ModuleRecord {
+            name,
+            classes: Span {
+                start: first_class,
+                end: self.map.classes.len() as u32,
+            },
+            enums: Span {
+                start: first_enum,
+                end: self.map.enums.len() as u32,
+            },
+        });
+    }
+
+    /// Links every class to its parent, in the same order the classes were pushed in.
+    ///
+    /// Parents that were resolved by pointer during the analysis know their module. All others
+    /// are looked up by name, preferring the module of the class itself.
+    fn resolve_parents(&mut self, scopes: &'a BTreeMap<String, (Vec<Class>, Vec<Enum>)>) {
+        let classes = || scopes.values().flat_map(|(classes, _)| classes);
+
+        let mut ids = HashMap::new();
+        let mut ids_by_name = HashMap::new();
+
+        for (id, class) in classes().enumerate() {
+            ids.entry((&*class.module_name, &*class.name))
+                .or_insert(id as u32);
+
+            ids_by_name.entry(&*class.name).or_insert(id as u32);
+        }
+
+        for (id, class) in classes().enumerate() {
+            let Some(parent) = &class.parent else {
+                continue;
+            };
+
+            let parent_id = if parent.module_name.is_empty() {
+                ids.get(&(&*class.module_name, &*parent.name))
+                    .or_else(|| ids_by_name.get(&*parent.name))
+            } else {
+                ids.get(&(&*parent.module_name, &*parent.name))
+            };
+
+            self.map.classes[id].parent = match parent_id {
+                Some(&parent_id) => ParentRecord::Class(parent_id),
+                None => ParentRecord::Name(self.str(&parent.name)),
+            };
+        }
+    }
+}
+
+/// The classes and enums of a single schema module.
+#[derive(Clone, Copy)]
+pub struct ModuleView<'a> {
+    pub name: &'a str,
+    map: &'a SchemaMap,
+    record: &'a ModuleRecord,
+}
+
+impl<'a> ModuleView<'a> {
+    pub fn classes(&self) -> impl ExactSizeIterator<Item = ClassView<'a>> + use<'a> {
+        let map = self.map;
+
+        (self.record.classes.start..self.record.classes.end).map(move |id| map.class(id))
+    }
+
+    pub fn enums(&self) -> impl ExactSizeIterator<Item = EnumView<'a>> + use<'a> {
+        let map = self.map;
+
+        map.enums[self.record.enums.range()]
+            .iter()
+            .map(move |record| EnumView {
+                name: map.str(record.name),
+                alignment: record.alignment,
+                size: record.size,
+                map,
+                members: record.members,
+            })
+    }
+}
+
+#[derive(Clone, Copy)]
+pub struct ClassView<'a> {
+    pub name: &'a str,
+    pub module_name: &'a str,
+
+    /// The name of the parent class, if any.
+    pub parent: Option<&'a str>,
+
+    pub alignment: u8,
+    pub size: i32,
+
+    map: &'a SchemaMap,
+    id: u32,
+}
+
+impl<'a> ClassView<'a> {
+    /// Returns the fields in declaration order.
+    pub fn fields(&self) -> impl ExactSizeIterator<Item = FieldView<'a>> + use<'a> {
+        let map = self.map;
+
+        map.fields[map.classes[self.id as usize].fields.range()]
+            .iter()
+            .map(move |record| FieldView {
+                name: map.str(record.name),
+                type_name: map.str(record.type_name),
+                offset: record.offset,
+            })
+    }
+
+    pub fn metadata(&self) -> impl ExactSizeIterator<Item = MetadataView<'a>> + use<'a> {
+        let map = self.map;
+
+        map.metadata[map.classes[self.id as usize].metadata.range()]
+            .iter()
+            .map(move |record| match *record {
+                MetadataRecord::Unknown { name } => MetadataView::Unknown {
+                    name: map.str(name),
+                },
+                MetadataRecord::NetworkChangeCallback { name } => {
+                    MetadataView::NetworkChangeCallback {
+                        name: map.str(name),
+                    }
+                }
+                MetadataRecord::NetworkVarNames { name, type_name } => {
+                    MetadataView::NetworkVarNames {
+                        name: map.str(name),
+                        type_name: map.str(type_name),
+                    }
+                }
+            })
+    }
+
+    /// Returns the parent class, if it is part of the map.
+    pub fn parent_class(&self) -> Option<ClassView<'a>> {
+        match self.map.classes[self.id as usize].parent {
+            ParentRecord::Class(id) => Some(self.map.class(id)),
+            _ => None,
+        }
+    }
+
+    /// Returns the fields of this class and all of its ancestors sorted by offset, each together
+    /// with the class that declares it.
+    ///
+    /// A field that is declared again further down the hierarchy is only included once, for the
+    /// most derived class.
+    pub fn flattened_fields(&self) -> Vec<(ClassView<'a>, FieldView<'a>)> {
+        let mut fields = Vec::new();
+
+        let mut names = HashSet::new();
+        let mut visited = HashSet::new();
+
+        let mut next = Some(*self);
+
+        while let Some(class) = next {
+            // Guards against cycles in a malformed hierarchy.
+            if !visited.insert(class.id) {
+                break;
+            }
+
+            for field in class.fields() {
+                if names.insert(field.name) {
+                    fields.push((class, field));
+                }
+            }
+
+            next = class.parent_class();
+        }
+
+        fields.sort_by_key(|(_, field)| field.offset);
+
+        fields
+    }
+}
+
+impl PartialEq for ClassView<'_> {
+    fn eq(&self, other: &Self) -> bool {
+        ptr::eq(self.map, other.map) && self.id == other.id
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct FieldView<'a> {
+    pub name: &'a str,
+    pub type_name: &'a str,
+    pub offset: i32,
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum MetadataView<'a> {
+    Unknown { name: &'a str },
+    NetworkChangeCallback { name: &'a str },
+    NetworkVarNames { name: &'a str, type_name: &'a str },
+}
+
+#[derive(Clone, Copy)]
+pub struct EnumView<'a> {
+    pub name: &'a str,
+    pub alignment: u8,
+    pub size: u16,
+    map: &'a SchemaMap,
+    members: Span,
+}
+
+impl<'a> EnumView<'a> {
+    /// Returns the members in declaration order.
+    pub fn members(&self) -> impl ExactSizeIterator<Item = MemberView<'a>> + use<'a> {
+        let map = self.map;
+
+        map.members[self.members.range()]
+            .iter()
+            .map(move |record| MemberView {
+                name: map.str(record.name),
+                value: record.value,
+            })
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct MemberView<'a> {
+    pub name: &'a str,
+    pub value: i64,
+}
+
+/// A class read from its binding, together with the name pointers that link it to its parent.
+struct BoundClass {
+    class: Class,
+    name_ptr: Address,
+    parent_name_ptr: Address,
+}
+
+pub const SCHEMA_MODULES: &[&str] = &["schemasystem.dll"];
 
-    let map = type_scopes
+pub fn schemas<P>(process: &mut P, ctx: &AnalysisContext) -> Result<SchemaMap>
+where
+    P: Target + Clone + Send,
+{
+    let schema_system = read_schema_system(process, ctx)?;
+    let type_scopes = read_type_scopes(process, ctx, &schema_system)?;
+
+    Ok(schema_map(type_scopes))
+}
+
+/// Like [`schemas`], but reads the type scopes in chunks and hands each chunk to `sink` as soon
+/// as it has been read, so that only a single chunk is held in memory at once. Returns the number
+/// of classes, enums and modules that were read.
+///
+/// A chunk holds one type scope per job. Once the peak heap usage exceeds `memory_budget`, the
+/// remaining type scopes are read one at a time. Parents in other chunks are linked by name, like
+/// those in reused type scopes.
+pub fn stream_schemas<P>(
+    process: &mut P,
+    ctx: &AnalysisContext,
+    memory_budget: Option<usize>,
+    sink: &mut SchemaSink,
+) -> Result<(usize, usize, usize)>
+where
+    P: Target + Clone + Send,
+{
+    let schema_system = read_schema_system(process, ctx)?;
+    let pending = pending_type_scopes(process, ctx, &schema_system)?;
+
+    let mut counts = (0, 0, 0);
+
+    let mut chunk_len = ctx.jobs;
+    let mut rest = &pending[..];
+
+    while !rest.is_empty() {
+        let (chunk, tail) = rest.split_at(chunk_len.min(rest.len()));
+
+        let map = schema_map(read_type_scope_chunk(process, ctx, chunk)?);
+
+        counts.0 += map.class_count();
+        counts.1 += map.enum_count();
+        counts.2 += map.len();
+
+        if chunk_len > 1 && memory_budget.is_some_and(|budget| metrics::peak_memory() > budget) {
+            warn!("exceeded the memory budget, reading the remaining type scopes one at a time");
+
+            chunk_len = 1;
+        }
+
+        sink(map)?;
+
+        rest = tail;
+    }
+
+    Ok(counts)
+}
+
+/// Reads the class bindings of a type scope whose name is accepted by `include`. Their parents
+/// are linked afterwards by [`resolve_parents`].
+///
+/// The bindings are traversed breadth-first: each level (bindings, names, field and metadata
+/// arrays, types and so on) is read for every binding at once in a single batch, which keeps the
+/// number of round trips to the target independent of the number of classes.
+fn read_class_bindings(
+    mem: &mut impl MemoryView,
+    strings: &StringCache,
+    binding_ptrs: &[Pointer64<SchemaClassBinding>],
+    include: &dyn Fn(&str) -> bool,
+) -> Result<Vec<BoundClass>> {
+    let bindings: Vec<SchemaClassBinding> =
+        read_batch(mem, binding_ptrs.iter().map(|ptr| ptr.address()))?;
+
+    let names = strings.read_all(mem, bindings.iter().map(|b| b.name.address()), 4096)?;
+
+    // Drop bindings without a name or outside of the filter before anything else is read for
+    // them.
+    let bindings: Vec<_> = binding_ptrs
+        .iter()
+        .zip(bindings)
+        .zip(names)
+        .filter(|(_, name)| !name.is_empty() && include(name))
+        .map(|((ptr, binding), name)| (*ptr, binding, name))
+        .collect();
+
+    let module_names = strings.read_all(
+        mem,
+        bindings.iter().map(|(_, b, _)| b.module_name.address()),
+        128,
+    )?;
+
+    let parent_name_ptrs = read_class_binding_parents(mem, &bindings)?;
+    let fields = read_class_binding_fields(mem, strings, &bindings)?;
+    let metadata = read_class_binding_metadata(mem, strings, &bindings)?;
+
+    let classes = bindings
+        .into_iter()
+        .zip(module_names)
+        .zip(parent_name_ptrs)
+        .zip(fields)
+        .zip(metadata)
+        .map(
+            |(((((binding_ptr, binding, name), module_name), parent_name_ptr), fields), metadata)| {
+                let module_name = strings.intern(&format!("{}.dll", module_name));
+
+                debug!(
+                    "found class: {} at {:#X} (module name: {}) (metadata count: {}) (field count: {})",
+                    name,
+                    binding_ptr.to_umem(),
+                    module_name,
+                    metadata.len(),
+                    fields.len(),
+                );
+
+                BoundClass {
+                    class: Class {
+                        name,
+                        module_name,
+                        parent: None,
+                        alignment: binding.align_of,
+                        size: binding.size,
+                        metadata,
+                        fields,
+                    },
+                    name_ptr: binding.name.address(),
+                    parent_name_ptr,
+                }
+            },
+        )
+        .collect();
+
+    Ok(classes)
+}
+
+/// Returns the address of the name of each binding's parent, or a null address for bindings
+/// without one.
+fn read_class_binding_parents(
+    mem: &mut impl MemoryView,
+    bindings: &[(Pointer64<SchemaClassBinding>, SchemaClassBinding, Arc<str>)],
+) -> Result<Vec<Address>> {
+    let base_classes: Vec<SchemaBaseClassInfoData> = read_batch(
+        mem,
+        bindings.iter().map(|(_, b, _)| b.base_classes.address()),
+    )?;
+
+    let parent_classes: Vec<SchemaBaseClass> =
+        read_batch(mem, base_classes.iter().map(|b| b.prev.address()))?;
+
+    Ok(parent_classes.iter().map(|c| c.name.address()).collect())
+}
+
+fn schema_map(type_scopes: Vec<TypeScope>) -> SchemaMap {
+    type_scopes
         .into_iter()
         .map(|type_scope| {
             (
@@ -72,225 +809,336 @@ pub fn schemas<P: Process + MemoryView>(process: &mut P) -> Result<SchemaMap> {
                 (type_scope.classes, type_scope.enums),
             )
         })
-        .collect();
-
-    Ok(map)
+        .collect()
 }
 
-fn read_class_binding(
+/// Links every class to its parent.
+///
+/// The base class of a binding refers to the same name string as the binding of the base class
+/// itself, so parents are matched by that pointer across all type scopes, which also identifies
+/// the module they belong to. Only parents whose binding wasn't read, e.g. because their type
+/// scope was reused from a previous run or excluded by the filter, fall back to reading their
+/// name.
+fn resolve_parents(
     mem: &mut impl MemoryView,
-    binding_ptr: Pointer64<SchemaClassBinding>,
-) -> Result<Class> {
-    let binding = mem.read_ptr(binding_ptr).data_part()?;
+    strings: &StringCache,
+    classes: &mut [&mut BoundClass],
+) -> Result<()> {
+    let by_name_ptr: HashMap<_, _> = classes
+        .iter()
+        .map(|bound| {
+            (
+                bound.name_ptr,
+                (bound.class.name.clone(), bound.class.module_name.clone()),
+            )
+        })
+        .collect();
+
+    let unresolved: Vec<_> = classes
+        .iter()
+        .map(|bound| bound.parent_name_ptr)
+        .filter(|ptr| !ptr.is_null() && !by_name_ptr.contains_key(ptr))
+        .collect();
 
-    let module_name = mem
-        .read_utf8_lossy(binding.module_name.address(), 128)
-        .data_part()
-        .map(|s| format!("{}.dll", s))?;
+    let unresolved_names: HashMap<_, _> = unresolved
+        .iter()
+        .copied()
+        .zip(strings.read_all(mem, unresolved.iter().copied(), 4096)?)
+        .collect();
 
-    let name = mem
-        .read_utf8_lossy(binding.name.address(), 4096)
-        .data_part()?;
+    let parent_count = classes
+        .iter()
+        .filter(|bound| !bound.parent_name_ptr.is_null())
+        .count();
 
-    if name.is_empty() {
-        bail!("empty class name");
-    }
+    debug!(
+        "resolved {} of {} parents by pointer",
+        parent_count - unresolved.len(),
+        parent_count,
+    );
 
-    let parent = binding.base_classes.non_null().and_then(|ptr| {
-        let base_class = mem.read_ptr(ptr).data_part().ok()?;
-        let parent_class = mem.read_ptr(base_class.prev).data_part().ok()?;
+    for bound in classes.iter_mut() {
+        let ptr = bound.parent_name_ptr;
 
-        let name = mem
-            .read_utf8_lossy(parent_class.name.address(), 4096)
-            .data_part()
-            .ok()?;
+        let (name, module_name) = match by_name_ptr.get(&ptr) {
+            Some(parent) => parent.clone(),
+            None => match unresolved_names.get(&ptr) {
+                Some(name) if !name.is_empty() => (name.clone(), strings.intern("")),
+                _ => continue,
+            },
+        };
 
-        Some(Box::new(Class {
+        bound.class.parent = Some(Box::new(Class {
             name,
-            module_name: String::new(),
+            module_name,
             parent: None,
+            alignment: 0,
+            size: 0,
             metadata: Vec::new(),
             fields: Vec::new(),
-        }))
-    });
-
-    let fields = read_class_binding_fields(mem, &binding)?;
-    let metadata = read_class_binding_metadata(mem, &binding)?;
-
-    debug!(
-        "found class: {} at {:#X} (module name: {}) (parent name: {:?}) (metadata count: {}) (field count: {})",
-        name,
-        binding_ptr.to_umem(),
-        module_name,
-        parent.as_ref().map(|p| p.name.clone()),
-        metadata.len(),
-        fields.len(),
-    );
+        }));
+    }
 
-    Ok(Class {
-        name,
-        module_name,
-        parent,
-        metadata,
-        fields,
-    })
+    Ok(())
 }
 
 fn read_class_binding_fields(
     mem: &mut impl MemoryView,
-    binding: &SchemaClassBinding,
-) -> Result<Vec<ClassField>> {
-    if binding.fields.is_null() {
-        return Ok(Vec::new());
-    }
-
-    (0..binding.field_count).try_fold(Vec::new(), |mut acc, i| {
-        let field = mem.read_ptr(binding.fields.at(i as _)).data_part()?;
+    strings: &StringCache,
+    bindings: &[(Pointer64<SchemaClassBinding>, SchemaClassBinding, Arc<str>)],
+) -> Result<Vec<Vec<ClassField>>> {
+    let field_arrays: Vec<Vec<SchemaClassFieldData>> = read_arrays(
+        mem,
+        bindings
+            .iter()
+            .map(|(_, b, _)| (b.fields.address(), b.field_count.max(0) as usize)),
+    )?;
+
+    let fields: Vec<_> = field_arrays
+        .iter()
+        .enumerate()
+        .flat_map(|(i, fields)| fields.iter().map(move |field| (i, field)))
+        .filter(|(_, field)| !field.r#type.is_null())
+        .collect();
 
-        if field.r#type.is_null() {
-            return Ok(acc);
-        }
+    let names = strings.read_all(mem, fields.iter().map(|(_, f)| f.name.address()), 4096)?;
 
-        let name = mem
-            .read_utf8_lossy(field.name.address(), 4096)
-            .data_part()?;
+    let types: Vec<SchemaType> = read_batch(mem, fields.iter().map(|(_, f)| f.r#type.address()))?;
 
-        let r#type = mem.read_ptr(field.r#type).data_part()?;
+    let type_names = strings.read_all(mem, types.iter().map(|t| t.name.address()), 128)?;
 
-        // TODO: Parse this properly.
-        let type_name = mem
-            .read_utf8_lossy(r#type.name.address(), 128)
-            .data_part()?
-            .replace(" ", "");
+    let mut class_fields = vec![Vec::new(); bindings.len()];
 
-        acc.push(ClassField {
+    for (((i, field), name), type_name) in fields.into_iter().zip(names).zip(type_names) {
+        // The spaces are dropped, e.g. `CHandle< C_BaseEntity >` becomes `CHandle<C_BaseEntity>`,
+        // so that type names can be matched as they are. They are parsed where struct layouts are
+        // written.
+        class_fields[i].push(ClassField {
             name,
-            type_name,
+            type_name: strings.intern(&type_name.replace(" ", "")),
             offset: field.offset,
         });
+    }
 
-        Ok(acc)
-    })
+    Ok(class_fields)
 }
 
 fn read_class_binding_metadata(
     mem: &mut impl MemoryView,
-    binding: &SchemaClassBinding,
-) -> Result<Vec<ClassMetadata>> {
-    if binding.static_metadata.is_null() {
-        return Ok(Vec::new());
-    }
-
-    (0..binding.static_metadata_count).try_fold(Vec::new(), |mut acc, i| {
-        let metadata = mem
-            .read_ptr(binding.static_metadata.at(i as _))
-            .data_part()?;
-
-        if metadata.network_value.is_null() {
-            return Ok(acc);
-        }
+    strings: &StringCache,
+    bindings: &[(Pointer64<SchemaClassBinding>, SchemaClassBinding, Arc<str>)],
+) -> Result<Vec<Vec<ClassMetadata>>> {
+    let metadata_arrays: Vec<Vec<SchemaMetadataEntryData>> = read_arrays(
+        mem,
+        bindings.iter().map(|(_, b, _)| {
+            (
+                b.static_metadata.address(),
+                b.static_metadata_count.max(0) as usize,
+            )
+        }),
+    )?;
+
+    let entries: Vec<_> = metadata_arrays
+        .iter()
+        .enumerate()
+        .flat_map(|(i, entries)| entries.iter().map(move |entry| (i, entry)))
+        .filter(|(_, entry)| !entry.network_value.is_null())
+        .collect();
 
-        let name = mem
-            .read_utf8_lossy(metadata.name.address(), 4096)
-            .data_part()?;
+    let names = strings.read_all(mem, entries.iter().map(|(_, e)| e.name.address()), 4096)?;
 
-        let network_value = mem.read_ptr(metadata.network_value).data_part()?;
+    let network_values: Vec<SchemaNetworkValue> =
+        read_batch(mem, entries.iter().map(|(_, e)| e.network_value.address()))?;
 
-        let metadata = match name.as_str() {
+    // Only the values of the metadata entries we know how to interpret are followed.
+    let value_ptrs: Vec<_> = names
+        .iter()
+        .zip(&network_values)
+        .map(|(name, network_value)| match name.as_ref() {
             "MNetworkChangeCallback" => unsafe {
-                let name = mem
-                    .read_utf8_lossy(network_value.value.name_ptr.address(), 4096)
-                    .data_part()?;
-
-                ClassMetadata::NetworkChangeCallback { name }
+                (network_value.value.name_ptr.address(), Address::NULL)
             },
             "MNetworkVarNames" => unsafe {
                 let var_value = network_value.value.var_value;
 
-                let name = mem
-                    .read_utf8_lossy(var_value.name.address(), 4096)
-                    .data_part()?;
+                (var_value.name.address(), var_value.type_name.address())
+            },
+            _ => (Address::NULL, Address::NULL),
+        })
+        .collect();
+
+    let value_names = strings.read_all(mem, value_ptrs.iter().map(|(name, _)| *name), 4096)?;
 
-                let type_name = mem
-                    .read_utf8_lossy(var_value.type_name.address(), 128)
-                    .data_part()?
-                    .replace(" ", "");
+    let value_type_names =
+        strings.read_all(mem, value_ptrs.iter().map(|(_, type_name)| *type_name), 128)?;
 
-                ClassMetadata::NetworkVarNames { name, type_name }
+    let mut class_metadata = vec![Vec::new(); bindings.len()];
+
+    for ((((i, _), name), value_name), value_type_name) in entries
+        .into_iter()
+        .zip(names)
+        .zip(value_names)
+        .zip(value_type_names)
+    {
+        let metadata = match name.as_ref() {
+            "MNetworkChangeCallback" => ClassMetadata::NetworkChangeCallback { name: value_name },
+            "MNetworkVarNames" => ClassMetadata::NetworkVarNames {
+                name: value_name,
+                type_name: strings.intern(&value_type_name.replace(" ", "")),
             },
             _ => ClassMetadata::Unknown { name },
         };
 
-        acc.push(metadata);
+        class_metadata[i].push(metadata);
+    }
 
-        Ok(acc)
-    })
+    Ok(class_metadata)
 }
 
-fn read_enum_binding(
+/// Reads all enum bindings of a type scope, traversing them breadth-first like
+/// [`read_class_bindings`].
+fn read_enum_bindings(
     mem: &mut impl MemoryView,
-    binding_ptr: Pointer64<SchemaEnumBinding>,
-) -> Result<Enum> {
-    let binding = mem.read_ptr(binding_ptr).data_part()?;
-
-    let name = mem
-        .read_utf8_lossy(binding.name.address(), 4096)
-        .data_part()?;
-
-    if name.is_empty() {
-        bail!("empty enum name");
-    }
+    strings: &StringCache,
+    binding_ptrs: &[Pointer64<SchemaEnumBinding>],
+    include: &dyn Fn(&str) -> bool,
+) -> Result<Vec<Enum>> {
+    let bindings: Vec<SchemaEnumBinding> =
+        read_batch(mem, binding_ptrs.iter().map(|ptr| ptr.address()))?;
+
+    let names = strings.read_all(mem, bindings.iter().map(|b| b.name.address()), 4096)?;
+
+    let bindings: Vec<_> = binding_ptrs
+        .iter()
+        .zip(bindings)
+        .zip(names)
+        .filter(|(_, name)| !name.is_empty() && include(name))
+        .map(|((ptr, binding), name)| (*ptr, binding, name))
+        .collect();
 
-    let members = read_enum_binding_members(mem, &binding)?;
+    let members = read_enum_binding_members(mem, strings, &bindings)?;
 
-    debug!(
-        "found enum: {} at {:#X} (alignment: {}) (member count: {})",
-        name,
-        binding_ptr.to_umem(),
-        binding.align_of,
-        binding.size,
-    );
+    let enums = bindings
+        .into_iter()
+        .zip(members)
+        .map(|((binding_ptr, binding, name), members)| {
+            debug!(
+                "found enum: {} at {:#X} (alignment: {}) (member count: {})",
+                name,
+                binding_ptr.to_umem(),
+                binding.align_of,
+                binding.size,
+            );
+
+            Enum {
+                name,
+                alignment: binding.align_of,
+                size: binding.enum_count,
+                members,
+            }
+        })
+        .collect();
 
-    Ok(Enum {
-        name,
-        alignment: binding.align_of,
-        size: binding.enum_count,
-        members,
-    })
+    Ok(enums)
 }
 
 fn read_enum_binding_members(
     mem: &mut impl MemoryView,
-    binding: &SchemaEnumBinding,
-) -> Result<Vec<EnumMember>> {
-    if binding.enums.is_null() {
-        return Ok(Vec::new());
-    }
+    strings: &StringCache,
+    bindings: &[(Pointer64<SchemaEnumBinding>, SchemaEnumBinding, Arc<str>)],
+) -> Result<Vec<Vec<EnumMember>>> {
+    let member_arrays: Vec<Vec<SchemaEnumeratorInfoData>> = read_arrays(
+        mem,
+        bindings
+            .iter()
+            .map(|(_, b, _)| (b.enums.address(), b.enum_count as usize)),
+    )?;
+
+    let members: Vec<_> = member_arrays
+        .iter()
+        .enumerate()
+        .flat_map(|(i, members)| members.iter().map(move |member| (i, member)))
+        .collect();
 
-    (0..binding.enum_count).try_fold(Vec::new(), |mut acc, i| {
-        let r#enum = mem.read_ptr(binding.enums.at(i as _)).data_part()?;
+    let names = strings.read_all(mem, members.iter().map(|(_, m)| m.name.address()), 4096)?;
 
-        let name = mem
-            .read_utf8_lossy(r#enum.name.address(), 4096)
-            .data_part()?;
+    let mut enum_members = vec![Vec::new(); bindings.len()];
 
-        acc.push(EnumMember {
+    for ((i, member), name) in members.into_iter().zip(names) {
+        enum_members[i].push(EnumMember {
             name,
-            value: unsafe { r#enum.value.ulong } as i64,
+            value: unsafe { member.value.ulong } as i64,
         });
+    }
 
-        Ok(acc)
-    })
+    Ok(enum_members)
 }
 
-fn read_schema_system<P: Process + MemoryView>(process: &mut P) -> Result<SchemaSystem> {
-    let module = process.module_by_name("schemasystem.dll")?;
+/// Reads one `T` from each address in a single batch. Null addresses are skipped and yield a
+/// zeroed value.
+fn read_batch<T: Pod + Sized>(
+    mem: &mut impl MemoryView,
+    addrs: impl IntoIterator<Item = Address>,
+) -> Result<Vec<T>> {
+    let addrs: Vec<_> = addrs.into_iter().collect();
+    let mut values: Vec<T> = addrs.iter().map(|_| T::zeroed()).collect();
+
+    let mut batcher = mem.batcher();
 
-    let buf = process
-        .read_raw(module.base, module.size as _)
-        .data_part()?;
+    for (addr, value) in addrs.iter().zip(values.iter_mut()) {
+        if !addr.is_null() {
+            batcher.read_into(*addr, value);
+        }
+    }
 
-    let view = PeView::from_bytes(&buf)?;
+    batcher.commit_rw().data_part()?;
+
+    drop(batcher);
+
+    Ok(values)
+}
+
+/// Reads one contiguous array of `T` from each `(address, length)` pair in a single batch. Null
+/// addresses yield an empty array.
+fn read_arrays<T: Pod + Sized>(
+    mem: &mut impl MemoryView,
+    arrays: impl IntoIterator<Item = (Address, usize)>,
+) -> Result<Vec<Vec<T>>> {
+    let arrays: Vec<_> = arrays.into_iter().collect();
+
+    let mut values: Vec<Vec<T>> = arrays
+        .iter()
+        .map(|(addr, len)| {
+            let len = if addr.is_null() { 0 } else { *len };
+
+            (0..len).map(|_| T::zeroed()).collect()
+        })
+        .collect();
+
+    let mut batcher = mem.batcher();
+
+    for ((addr, _), values) in arrays.iter().zip(values.iter_mut()) {
+        if !values.is_empty() {
+            batcher.read_into(*addr, values.as_mut_slice());
+        }
+    }
+
+    batcher.commit_rw().data_part()?;
+
+    drop(batcher);
+
+    Ok(values)
+}
+
+fn read_schema_system<P: Target>(process: &mut P, ctx: &AnalysisContext) -> Result<SchemaSystem> {
+    let image = ctx
+        .cache
+        .image_by_name(process, "schemasystem.dll", ImageParts::CODE)?;
+    let module = &image.module;
+
+    let view = image.view()?;
+
+    let _span = ctx.span("scan", "schemasystem.dll");
 
     let mut save = [0; 2];
 
@@ -310,52 +1158,255 @@ fn read_schema_system<P: Process + MemoryView>(process: &mut P) -> Result<Schema
     Ok(schema_system)
 }
 
-fn read_type_scopes(
+/// A type scope that is neither reused from the baseline nor filtered out, and has yet to be read.
+type PendingTypeScope = (
+    Pointer64<SchemaSystemTypeScope>,
+    SchemaSystemTypeScope,
+    String,
+);
+
+/// Reads every type scope that is neither reused from the baseline nor filtered out.
+fn read_type_scopes<P>(
+    process: &mut P,
+    ctx: &AnalysisContext,
+    schema_system: &SchemaSystem,
+) -> Result<Vec<TypeScope>>
+where
+    P: Target + Clone + Send,
+{
+    let pending = pending_type_scopes(process, ctx, schema_system)?;
+
+    read_type_scope_chunk(process, ctx, &pending)
+}
+
+/// Reads the headers of all type scopes up front, in two batches, and returns those that have to
+/// be read.
+fn pending_type_scopes(
     mem: &mut impl MemoryView,
+    ctx: &AnalysisContext,
     schema_system: &SchemaSystem,
-) -> Result<Vec<TypeScope>> {
+) -> Result<Vec<PendingTypeScope>> {
     let type_scopes = &schema_system.type_scopes;
 
-    (0..type_scopes.size).try_fold(Vec::new(), |mut acc, i| {
-        let type_scope_ptr = type_scopes.element(mem, i as _)?;
-        let type_scope = mem.read_ptr(type_scope_ptr).data_part()?;
+    let type_scope_ptrs: Vec<Pointer64<SchemaSystemTypeScope>> = read_arrays(
+        mem,
+        [(type_scopes.mem.address(), type_scopes.size.max(0) as usize)],
+    )?
+    .pop()
+    .unwrap_or_default();
 
-        let module_name = unsafe { CStr::from_ptr(type_scope.name.as_ptr()) }
-            .to_string_lossy()
-            .to_string();
+    let headers: Vec<SchemaSystemTypeScope> =
+        read_batch(mem, type_scope_ptrs.iter().map(|ptr| ptr.address()))?;
 
-        let classes: Vec<_> = type_scope
-            .class_bindings
-            .elements(mem)?
-            .iter()
-            .filter_map(|ptr| read_class_binding(mem, *ptr).ok())
-            .collect();
+    let pending = type_scope_ptrs
+        .into_iter()
+        .zip(headers)
+        .filter_map(|(type_scope_ptr, type_scope)| {
+            let module_name = unsafe { CStr::from_ptr(type_scope.name.as_ptr()) }
+                .to_string_lossy()
+                .to_string();
+
+            // The files of unchanged type scopes are left in place by the output.
+            if ctx
+                .baseline
+                .as_ref()
+                .is_some_and(|baseline| baseline.schemas.contains(&module_name))
+            {
+                debug!("reusing type scope: {}", module_name);
+
+                return None;
+            }
+
+            if !ctx.filter.includes_module(Analyzer::Schemas, &module_name) {
+                return None;
+            }
+
+            Some((type_scope_ptr, type_scope, module_name))
+        })
+        .collect();
 
-        let enums: Vec<_> = type_scope
-            .enum_bindings
-            .elements(mem)?
-            .iter()
-            .filter_map(|ptr| read_enum_binding(mem, *ptr).ok())
-            .collect();
+    Ok(pending)
+}
 
-        if classes.is_empty() && enums.is_empty() {
-            return Ok(acc);
-        }
+/// Reads the bindings of the given type scopes and parses them on up to `ctx.jobs` workers, so
+/// that the reads of some type scopes are in flight while others are being parsed.
+fn read_type_scope_chunk<P>(
+    process: &mut P,
+    ctx: &AnalysisContext,
+    pending: &[PendingTypeScope],
+) -> Result<Vec<TypeScope>>
+where
+    P: Target + Clone + Send,
+{
+    let scopes = par_map(
+        process,
+        ctx.jobs,
+        pending,
+        |mem, (type_scope_ptr, type_scope, module_name)| {
+            read_type_scope(mem, ctx, *type_scope_ptr, type_scope, module_name)
+        },
+    );
 
-        debug!(
-            "found type scope: {} at {:#X} (class count: {}) (enum count: {})",
-            module_name,
-            type_scope_ptr.to_umem(),
-            classes.len(),
-            enums.len(),
-        );
+    let mut scopes: Vec<_> = scopes
+        .into_iter()
+        .collect::<Result<Vec<_>>>()?
+        .into_iter()
+        .flatten()
+        .collect();
 
-        acc.push(TypeScope {
+    let mut classes: Vec<_> = scopes
+        .iter_mut()
+        .flat_map(|(_, classes, _)| classes.iter_mut())
+        .collect();
+
+    resolve_parents(process, &ctx.strings, &mut classes)?;
+
+    let type_scopes = scopes
+        .into_iter()
+        .map(|(module_name, classes, enums)| TypeScope {
             module_name,
-            classes,
+            classes: classes.into_iter().map(|bound| bound.class).collect(),
             enums,
-        });
+        })
+        .collect();
+
+    Ok(type_scopes)
+}
+
+/// Reads the class and enum bindings of a type scope. Returns `None` if none of them are
+/// included by the filter.
+fn read_type_scope(
+    mem: &mut impl MemoryView,
+    ctx: &AnalysisContext,
+    type_scope_ptr: Pointer64<SchemaSystemTypeScope>,
+    type_scope: &SchemaSystemTypeScope,
+    module_name: &str,
+) -> Result<Option<(String, Vec<BoundClass>, Vec<Enum>)>> {
+    let strings = &ctx.strings;
+
+    let include = |name: &str| {
+        ctx.filter
+            .includes_name(Analyzer::Schemas, module_name, name)
+    };
+
+    let _span = ctx.span("schemas", module_name);
+
+    let class_ptrs = type_scope.class_bindings.elements(mem)?;
+    let classes = read_class_bindings(mem, strings, &class_ptrs, &include)?;
+
+    let enum_ptrs = type_scope.enum_bindings.elements(mem)?;
+    let enums = read_enum_bindings(mem, strings, &enum_ptrs, &include)?;
+
+    if classes.is_empty() && enums.is_empty() {
+        return Ok(None);
+    }
+
+    debug!(
+        "found type scope: {} at {:#X} (class count: {}) (enum count: {})",
+        module_name,
+        type_scope_ptr.to_umem(),
+        classes.len(),
+        enums.len(),
+    );
+
+    Ok(Some((module_name.to_string(), classes, enums)))
+}
+
+#[cfg(test)]
+mod tests {
+    use std::time::Instant;
+
+    use crate::analysis::tests::bench_context;
+    use crate::target::Replay;
+
+    use super::*;
+
+    #[test]
+    fn flattened_fields() {
+        let schemas: SchemaMap = [(
+            "client.dll".to_string(),
+            (
+                vec![
+                    Class::new("client.dll", "C_CSPlayerPawn")
+                        .with_parent(Some("C_BasePlayerPawn"))
+                        .with_fields([("m_iShotsFired", "", 0x20)]),
+                    Class::new("client.dll", "C_BasePlayerPawn")
+                        .with_parent(Some("C_BaseEntity"))
+                        .with_fields([("m_pWeaponServices", "", 0x18), ("m_iHealth", "", 0x30)]),
+                    Class::new("client.dll", "C_BaseEntity")
+                        .with_fields([("m_iHealth", "", 0x10), ("m_fFlags", "", 0x14)]),
+                    // A malformed hierarchy must not loop forever.
+                    Class::new("client.dll", "A")
+                        .with_parent(Some("B"))
+                        .with_fields([("m_a", "", 0x0)]),
+                    Class::new("client.dll", "B")
+                        .with_parent(Some("A"))
+                        .with_fields([("m_b", "", 0x8)]),
+                    Class::new("client.dll", "C").with_parent(Some("CMissing")),
+                ],
+                Vec::new(),
+            ),
+        )]
+        .into_iter()
+        .collect();
+
+        let classes: Vec<_> = schemas.module("client.dll").unwrap().classes().collect();
+
+        let fields: Vec<_> = classes[0]
+            .flattened_fields()
+            .into_iter()
+            .map(|(owner, field)| (owner.name, field.name, field.offset))
+            .collect();
+
+        // The redeclared `m_iHealth` of the base class is left out.
+        assert_eq!(
+            fields,
+            [
+                ("C_BaseEntity", "m_fFlags", 0x14),
+                ("C_BasePlayerPawn", "m_pWeaponServices", 0x18),
+                ("C_CSPlayerPawn", "m_iShotsFired", 0x20),
+                ("C_BasePlayerPawn", "m_iHealth", 0x30),
+            ]
+        );
+
+        assert_eq!(classes[3].flattened_fields().len(), 2);
+
+        // Parents outside of the map keep their name.
+        assert_eq!(classes[5].parent, Some("CMissing"));
+        assert!(classes[5].parent_class().is_none());
+    }
 
-        Ok(acc)
-    })
+    #[test]
+    #[ignore = "benchmark"]
+    fn walk_type_scopes() -> Result<()> {
+        let mut replay = Replay::open_bench()?;
+
+        let ctx = bench_context();
+
+        let schema_system = read_schema_system(&mut replay, &ctx)?;
+        let type_scopes = &schema_system.type_scopes;
+
+        let batches = replay.batches();
+        let now = Instant::now();
+
+        let mut bindings = 0;
+
+        for i in 0..type_scopes.size {
+            let type_scope_ptr = type_scopes.element(&mut replay, i as _)?;
+            let type_scope = replay.read_ptr(type_scope_ptr).data_part()?;
+
+            bindings += type_scope.class_bindings.elements(&mut replay)?.len();
+            bindings += type_scope.enum_bindings.elements(&mut replay)?.len();
+        }
+
+        println!(
+            "walked {} bindings across {} type scopes in {:.2?} ({} read batches)",
+            bindings,
+            type_scopes.size,
+            now.elapsed(),
+            replay.batches() - batches
+        );
+
+        Ok(())
+    }
 }
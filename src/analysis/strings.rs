@@ -0,0 +1,145 @@
+use std::collections::{HashMap, HashSet};
+use std::sync::{Arc, Mutex};
+
+use anyhow::Result;
+
+use memflow::prelude::v1::*;
+
+/// The number of bytes fetched per string before it is extended.
+const CHUNK_LEN: usize = 64;
+
+/// The maximum number of strings to read per batch, which bounds the size of the read buffer.
+const BATCH_LEN: usize = 1024;
+
+/// Reads NUL-terminated strings from the target and interns them.
+///
+/// Strings are cached by address and length bound, so a string referenced from many places (e.g.
+/// the type name of a field) is only read once per [`analyze_all`](super::analyze_all) call, and a
+/// string read with a short bound is never handed out for a longer one. Equal strings share a
+/// single allocation, regardless of the address they were read from.
+#[derive(Default)]
+pub struct StringCache {
+    by_addr: Mutex<HashMap<(Address, usize), Arc<str>>>,
+    interned: Mutex<HashSet<Arc<str>>>,
+}
+
+impl StringCache {
+    /// Returns the shared copy of `s`.
+    pub fn intern(&self, s: &str) -> Arc<str> {
+        let mut interned = self.interned.lock().unwrap();
+
+        if let Some(s) = interned.get(s) {
+            return s.clone();
+        }
+
+        let s: Arc<str> = Arc::from(s);
+
+        interned.insert(s.clone());
+
+        s
+    }
+
+    /// Reads a string of at most `max_len` bytes from each address. Null addresses yield an empty
+    /// string.
+    ///
+    /// Each string is fetched in chunks of [`CHUNK_LEN`] bytes, and only extended while no NUL
+    /// terminator has been found.
+    pub fn read_all(
+        &self,
+        mem: &mut impl MemoryView,
+        addrs: impl IntoIterator<Item = Address>,
+        max_len: usize,
+    ) -> Result<Vec<Arc<str>>> {
+        let addrs: Vec<_> = addrs.into_iter().collect();
+
+        let pending: Vec<_> = {
+            let by_addr = self.by_addr.lock().unwrap();
+
+            let mut seen = HashSet::new();
+
+            addrs
+                .iter()
+                .copied()
+                .filter(|addr| {
+                    !addr.is_null() && !by_addr.contains_key(&(*addr, max_len)) && seen.insert(*addr)
+                })
+                .collect()
+        };
+
+        if !pending.is_empty() {
+            let strings = read_chunked(mem, &pending, max_len)?;
+
+            let strings: Vec<_> = strings
+                .iter()
+                .map(|buf| self.intern(&String::from_utf8_lossy(buf)))
+                .collect();
+
+            let mut by_addr = self.by_addr.lock().unwrap();
+
+            by_addr.extend(pending.into_iter().map(|addr| (addr, max_len)).zip(strings));
+        }
+
+        let empty = self.intern("");
+
+        let by_addr = self.by_addr.lock().unwrap();
+
+        let strings = addrs
+            .iter()
+            .map(|addr| by_addr.get(&(*addr, max_len)).unwrap_or(&empty).clone())
+            .collect();
+
+        Ok(strings)
+    }
+}
+
+/// Reads the raw bytes of a string from each address, excluding the NUL terminator.
+fn read_chunked(
+    mem: &mut impl MemoryView,
+    addrs: &[Address],
+    max_len: usize,
+) -> Result<Vec<Vec<u8>>> {
+    let mut bufs: Vec<Vec<u8>> = addrs.iter().map(|_| Vec::new()).collect();
+
+    let mut len = CHUNK_LEN.min(max_len);
+
+    loop {
+        // Only strings that have not been terminated yet are extended.
+        let mut open: Vec<_> = addrs
+            .iter()
+            .zip(bufs.iter_mut())
+            .filter(|(_, buf)| !buf.contains(&0))
+            .collect();
+
+        if open.is_empty() {
+            break;
+        }
+
+        for batch in open.chunks_mut(BATCH_LEN) {
+            let mut batcher = mem.batcher();
+
+            for (addr, buf) in batch.iter_mut() {
+                let start = buf.len();
+
+                buf.resize(len, 0);
+
+                batcher.read_raw_into(**addr + start, &mut buf[start..]);
+            }
+
+            batcher.commit_rw().data_part()?;
+        }
+
+        if len == max_len {
+            break;
+        }
+
+        len = (len * 2).min(max_len);
+    }
+
+    for buf in &mut bufs {
+        let len = buf.iter().position(|&b| b == 0).unwrap_or(buf.len());
+
+        buf.truncate(len);
+    }
+
+    Ok(bufs)
+}
@@ -1,30 +1,55 @@
 #![allow(dead_code)]
 #![allow(unused_imports)]
 
+use std::collections::BTreeMap;
 use std::fs::File;
-use std::path::PathBuf;
+use std::path::{Path, PathBuf};
 use std::str::FromStr;
-use std::time::Instant;
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, Instant};
 
-use anyhow::Result;
+use anyhow::{Result, bail};
 
 use clap::{ArgAction, Parser};
 
-use log::{LevelFilter, info};
+use log::{LevelFilter, error, info, warn};
 
 use memflow::prelude::v1::*;
 
 use simplelog::*;
 
-use output::Output;
+use analysis::{AnalysisResult, Analyzer, Baseline, Filter, FilterRule, OFFSET_MODULES};
+
+use metrics::Metrics;
+
+use output::{Manifest, Output, SchemaOptions};
+
+use serve::Server;
+
+use target::{Capture, Metered, Offline, Replay, Target, TargetSpec};
 
 mod analysis;
+mod metrics;
 mod output;
+mod serve;
 mod source2;
+mod target;
 
 #[derive(Debug, Parser)]
 #[command(author, version)]
 struct Args {
+    /// Also write every file of the output directory into a single zstd-compressed
+    /// `cs2_dumper.bundle`, with an index of content hashes. Files that are unchanged since the
+    /// previous bundle reuse its compressed data.
+    #[arg(long)]
+    bundle: bool,
+
+    /// Record every memory page read during the dump into the given file, for later use with
+    /// `--replay`.
+    #[arg(long, value_name = "FILE", conflicts_with_all = ["replay", "watch"])]
+    capture: Option<PathBuf>,
+
     /// The name of the memflow connector to use.
     #[arg(short, long)]
     connector: Option<String>,
@@ -33,14 +58,74 @@ struct Args {
     #[arg(short = 'a', long)]
     connector_args: Option<String>,
 
+    /// Write the offsets, interfaces, buttons and schema fields that were added, removed or moved
+    /// since the previous dump in the output directory into `delta.json`. Requires the `json` file
+    /// type.
+    #[arg(long)]
+    delta: bool,
+
     /// The types of files to generate.
     #[arg(short, long, value_delimiter = ',', default_values = ["cs", "hpp", "json", "rs"])]
     file_types: Vec<String>,
 
+    /// Include the inherited fields of every class in the schema files, sorted by offset.
+    #[arg(long)]
+    flatten: bool,
+
+    /// Search for every offset pattern near where it matched in the previous run first, and only
+    /// scan the whole module if it isn't found there.
+    #[arg(long)]
+    hints: bool,
+
+    /// Skip the analysis of modules that did not change since the previous run in the output
+    /// directory.
+    #[arg(long)]
+    incremental: bool,
+
     /// The number of spaces to use per indentation level.
     #[arg(short, long, default_value_t = 4)]
     indent_size: usize,
 
+    /// The maximum number of worker threads to use for analysis and code generation. Parallel
+    /// analysis requires a connector that supports concurrent reads.
+    #[arg(short, long, default_value_t = 1)]
+    jobs: usize,
+
+    /// Append the `repr(C)` struct of every class to every `hpp` and `rs` schema file, with
+    /// explicit padding between the fields, so that whole objects can be read at once.
+    #[arg(long)]
+    layouts: bool,
+
+    /// Append a perfect-hash table to every `hpp` and `rs` schema file, for looking up field
+    /// offsets by class and field name at runtime.
+    #[arg(long)]
+    lookup_tables: bool,
+
+    /// The heap memory budget of `--stream` in MiB. Once the heap usage exceeds it, the remaining
+    /// type scopes are read one at a time. The peak usage is reported in the `--metrics` file.
+    #[arg(long, value_name = "MIB", requires = "stream")]
+    max_memory: Option<usize>,
+
+    /// Write the timing of every stage and the read traffic of every analyzer into the given
+    /// file.
+    #[arg(long, value_name = "FILE", conflicts_with = "watch")]
+    metrics: Option<PathBuf>,
+
+    /// The format of the `--metrics` file: a JSON report, or a Chrome trace.
+    #[arg(long, value_name = "FORMAT", default_value = "report", value_parser = ["report", "trace"])]
+    metrics_format: String,
+
+    /// Find the offsets in the module files of the given game directory, without the game
+    /// running. Everything else is only built at runtime, and is left out.
+    #[arg(long, value_name = "GAME_DIR", conflicts_with_all = ["replay", "watch"])]
+    offline: Option<PathBuf>,
+
+    /// Restrict the analysis to the given analyzers, modules and names, written as
+    /// `ANALYZER[:MODULE[/NAME]]` (e.g. `schemas:client.dll` or `offsets:*/dwEntityList`). Modules
+    /// and names are globs. Can be specified multiple times.
+    #[arg(long, value_delimiter = ',', value_name = "FILTER")]
+    only: Vec<FilterRule>,
+
     /// The output directory to write the generated files to.
     #[arg(short, long, default_value = "output")]
     output: PathBuf,
@@ -49,6 +134,51 @@ struct Args {
     #[arg(short, long, default_value = "cs2.exe")]
     process_name: String,
 
+    /// Dump from a file recorded with `--capture` instead of from the game process.
+    #[arg(long, value_name = "FILE", conflicts_with = "watch")]
+    replay: Option<PathBuf>,
+
+    /// The delay to add to every batch of reads during `--replay`, to mimic the latency of a
+    /// connector.
+    #[arg(long, value_name = "MICROSECONDS", default_value_t = 0)]
+    replay_latency: u64,
+
+    /// Answer lookups of single offsets, interfaces, buttons and schema fields of the latest dump
+    /// over HTTP on the given address (e.g. `127.0.0.1:7878`), swapping in every new dump of
+    /// `--watch` as soon as it is done.
+    #[arg(
+        long,
+        value_name = "ADDR",
+        requires = "watch",
+        conflicts_with = "stream"
+    )]
+    serve: Option<String>,
+
+    /// Write the files of every few type scopes as soon as they have been read, and drop them
+    /// before reading the next ones, instead of holding all schemas until the end. Parents in
+    /// other type scopes are only known by name, so this can't be combined with `--flatten`,
+    /// `--delta` or the `bin` file type.
+    #[arg(long, conflicts_with_all = ["delta", "flatten"])]
+    stream: bool,
+
+    /// Dump several targets at once, each written as `NAME=[CONNECTOR[:ARGS]][@PID]` (e.g.
+    /// `beta=kvm:vm-beta` or `local=@1234`) and into its own subdirectory of the output directory.
+    /// Targets running the same build are only analyzed once. Can be specified multiple times.
+    #[arg(
+        long = "target",
+        value_name = "TARGET",
+        conflicts_with_all = [
+            "capture", "connector", "connector_args", "incremental", "metrics", "offline", "replay",
+            "stream", "watch",
+        ]
+    )]
+    targets: Vec<TargetSpec>,
+
+    /// Stay attached to the process and dump again whenever its modules change, polling every
+    /// given number of seconds.
+    #[arg(short, long, value_name = "SECONDS", num_args = 0..=1, default_missing_value = "5")]
+    watch: Option<u64>,
+
     /// Increase logging verbosity. Can be specified multiple times.
     #[arg(short, long, action = ArgAction::Count)]
     verbose: u8,
@@ -58,6 +188,29 @@ struct Args {
     no_log_file: bool,
 }
 
+impl Args {
+    fn filter(&self) -> Filter {
+        let filter = Filter::new(self.only.iter().cloned());
+
+        match self.offline {
+            Some(_) => filter.restrict(Analyzer::Offsets),
+            None => filter,
+        }
+    }
+
+    fn memory_budget(&self) -> Option<usize> {
+        self.max_memory.map(|mib| mib << 20)
+    }
+
+    fn schema_options(&self) -> SchemaOptions {
+        SchemaOptions {
+            flatten: self.flatten,
+            layouts: self.layouts,
+            lookup_tables: self.lookup_tables,
+        }
+    }
+}
+
 fn main() -> Result<()> {
     let args = Args::parse();
 
@@ -87,44 +240,577 @@ fn main() -> Result<()> {
 
     CombinedLogger::init(loggers)?;
 
+    if args.delta && !args.file_types.iter().any(|file_type| file_type == "json") {
+        bail!("--delta requires the json file type");
+    }
+
+    if args.stream && args.file_types.iter().any(|file_type| file_type == "bin") {
+        bail!("--stream can't write the bin file type");
+    }
+
+    if args.metrics.is_some() || args.max_memory.is_some() {
+        metrics::track_memory();
+    }
+
+    if let Some(file_path) = &args.replay {
+        let latency = Duration::from_micros(args.replay_latency);
+
+        return run(&args, &mut Replay::open(file_path, latency)?);
+    }
+
+    if let Some(game_dir) = &args.offline {
+        if !Filter::new(args.only.iter().cloned()).includes(Analyzer::Offsets) {
+            bail!("--offline can only find offsets");
+        }
+
+        let filter = args.filter();
+
+        let module_names: Vec<_> = OFFSET_MODULES
+            .iter()
+            .map(|(module_name, _)| *module_name)
+            .filter(|module_name| filter.includes_module(Analyzer::Offsets, module_name))
+            .collect();
+
+        return run(&args, &mut Offline::open(game_dir, &module_names)?);
+    }
+
+    if !args.targets.is_empty() {
+        return dump_targets(&args);
+    }
+
     let conn_args = args
         .connector_args
-        .map(|s| ConnectorArgs::from_str(&s).expect("unable to parse connector arguments"))
+        .as_deref()
+        .map(|s| ConnectorArgs::from_str(s).expect("unable to parse connector arguments"))
         .unwrap_or_default();
 
-    let mut os = match args.connector {
-        Some(conn) => {
-            let mut inventory = Inventory::scan();
+    let os = open_os(&mut None, args.connector.as_deref(), conn_args)?;
 
-            inventory
-                .builder()
-                .connector(&conn)
-                .args(conn_args)
-                .os("win32")
-                .build()?
-        }
+    let mut process = os.clone().into_process_by_name(&args.process_name)?;
+
+    if let Some(interval) = args.watch {
+        let server = args.serve.as_deref().map(Server::start).transpose()?;
+
+        return watch(
+            &args,
+            os,
+            process,
+            Duration::from_secs(interval),
+            server.as_ref(),
+        );
+    }
+
+    if let Some(file_path) = &args.capture {
+        let mut capture = Capture::new(process);
+
+        run(&args, &mut capture)?;
+
+        let snapshot = capture.take_snapshot();
+
+        snapshot.save(file_path)?;
+
+        info!(
+            "captured {} pages of memory to {}",
+            snapshot.pages.len(),
+            file_path.display()
+        );
+
+        return Ok(());
+    }
+
+    run(&args, &mut process)
+}
+
+/// Creates the OS layer of a connector, or of the native connector if none is given. The
+/// inventory of connectors is only scanned once, the first time it is needed.
+fn open_os(
+    inventory: &mut Option<Inventory>,
+    connector: Option<&str>,
+    conn_args: ConnectorArgs,
+) -> Result<OsInstanceArcBox<'static>> {
+    match connector {
+        Some(conn) => Ok(inventory
+            .get_or_insert_with(Inventory::scan)
+            .builder()
+            .connector(conn)
+            .args(conn_args)
+            .os("win32")
+            .build()?),
         None => {
             #[cfg(windows)]
             {
-                memflow_native::create_os(&OsArgs::default(), LibArc::default())?
+                Ok(memflow_native::create_os(
+                    &OsArgs::default(),
+                    LibArc::default(),
+                )?)
             }
             #[cfg(not(windows))]
             {
                 panic!("no connector specified")
             }
         }
+    }
+}
+
+fn run<P>(args: &Args, process: &mut P) -> Result<()>
+where
+    P: Target + Clone + Send,
+{
+    let Some(file_path) = &args.metrics else {
+        return run_once(args, process, None);
     };
 
-    let mut process = os.process_by_name(&args.process_name)?;
+    let metrics = Arc::new(Metrics::new());
 
+    if let Some(budget) = args.memory_budget() {
+        metrics.set_memory_budget(budget);
+    }
+
+    run_once(
+        args,
+        &mut Metered::new(process.clone(), metrics.clone()),
+        Some(metrics.clone()),
+    )?;
+
+    metrics.write(file_path, &args.metrics_format)?;
+
+    info!("wrote metrics to {}", file_path.display());
+
+    Ok(())
+}
+
+fn run_once<P>(args: &Args, process: &mut P, metrics: Option<Arc<Metrics>>) -> Result<()>
+where
+    P: Target + Clone + Send,
+{
+    process.set_stage("manifest");
+
+    let manifest = args
+        .incremental
+        .then(|| {
+            Manifest::new(
+                process,
+                &args.file_types,
+                &args.filter(),
+                args.indent_size,
+                args.schema_options(),
+            )
+        })
+        .transpose()?;
+
+    let baseline = manifest
+        .as_ref()
+        .and_then(|manifest| manifest.baseline(&args.output));
+
+    dump(args, process, manifest.as_ref(), baseline, metrics)?;
+
+    Ok(())
+}
+
+fn dump<P>(
+    args: &Args,
+    process: &mut P,
+    manifest: Option<&Manifest>,
+    baseline: Option<Baseline>,
+    metrics: Option<Arc<Metrics>>,
+) -> Result<AnalysisResult>
+where
+    P: Target + Clone + Send,
+{
     let now = Instant::now();
 
-    let result = analysis::analyze_all(&mut process)?;
-    let output = Output::new(&args.file_types, args.indent_size, &args.output, &result)?;
+    let result = if args.stream {
+        dump_streaming(args, process, manifest, baseline, metrics)?
+    } else {
+        let result = analyze(args, process, &args.output, baseline, metrics.clone())?;
 
-    output.dump_all(&mut process)?;
+        write_output(
+            args,
+            process,
+            manifest,
+            &args.output,
+            &result,
+            metrics.as_deref(),
+        )?;
+
+        result
+    };
 
     info!("analysis completed in {:.2?}", now.elapsed());
 
+    if let Some(budget) = args.memory_budget() {
+        if metrics::peak_memory() > budget {
+            warn!(
+                "peak heap usage of {} bytes exceeded the memory budget of {} bytes",
+                metrics::peak_memory(),
+                budget
+            );
+        }
+    }
+
+    Ok(result)
+}
+
+/// Writes the files of the schemas as they are read, see `--stream`, and everything else once
+/// the analysis is done. The returned result holds no schemas.
+fn dump_streaming<P>(
+    args: &Args,
+    process: &mut P,
+    manifest: Option<&Manifest>,
+    baseline: Option<Baseline>,
+    metrics: Option<Arc<Metrics>>,
+) -> Result<AnalysisResult>
+where
+    P: Target + Clone + Send,
+{
+    let output = output(args, manifest, &args.output, metrics.as_deref())?;
+
+    let hints = args.hints.then(|| output::read_hints(&args.output));
+
+    // A failing sink only stops the schemas analyzer, which logs the error and carries on, so the
+    // error is kept here to fail the dump like any other output error.
+    let mut dump_err = None;
+
+    let result = analysis::analyze_streaming(
+        process,
+        args.jobs,
+        baseline,
+        args.filter(),
+        hints,
+        metrics.clone(),
+        args.memory_budget(),
+        &mut |schemas| match output.dump_schemas(&schemas) {
+            Ok(()) => Ok(()),
+            Err(err) => {
+                let msg = err.to_string();
+
+                dump_err = Some(err);
+
+                bail!("{}", msg)
+            }
+        },
+    )?;
+
+    if let Some(err) = dump_err {
+        return Err(err);
+    }
+
+    output.dump_all(process, &result)?;
+
+    Ok(result)
+}
+
+fn analyze<P>(
+    args: &Args,
+    process: &mut P,
+    out_dir: &Path,
+    baseline: Option<Baseline>,
+    metrics: Option<Arc<Metrics>>,
+) -> Result<AnalysisResult>
+where
+    P: Target + Clone + Send,
+{
+    let hints = args.hints.then(|| output::read_hints(out_dir));
+
+    analysis::analyze_all(process, args.jobs, baseline, args.filter(), hints, metrics)
+}
+
+fn write_output<P: Target>(
+    args: &Args,
+    process: &mut P,
+    manifest: Option<&Manifest>,
+    out_dir: &Path,
+    result: &AnalysisResult,
+    metrics: Option<&Metrics>,
+) -> Result<()> {
+    output(args, manifest, out_dir, metrics)?.dump_all(process, result)
+}
+
+fn output<'a>(
+    args: &'a Args,
+    manifest: Option<&'a Manifest>,
+    out_dir: &'a Path,
+    metrics: Option<&'a Metrics>,
+) -> Result<Output<'a>> {
+    Output::new(
+        args.bundle,
+        args.delta,
+        &args.file_types,
+        args.indent_size,
+        args.jobs,
+        manifest,
+        metrics,
+        out_dir,
+        args.schema_options(),
+    )
+}
+
+/// A `--target` that has been attached to.
+struct OpenTarget<'a> {
+    spec: &'a TargetSpec,
+    process: IntoProcessInstanceArcBox<'static>,
+}
+
+/// Dumps every `--target` into its own subdirectory of the output directory.
+///
+/// Targets whose game modules have the same hashes run the same build, so only the first of them
+/// is analyzed, and its result is written for all of them. Every build is analyzed on its own
+/// thread.
+fn dump_targets(args: &Args) -> Result<()> {
+    let mut inventory = None;
+
+    let mut builds: Vec<(BTreeMap<String, String>, Vec<OpenTarget>)> = Vec::new();
+
+    for spec in &args.targets {
+        let conn_args = spec
+            .connector_args
+            .as_deref()
+            .map(ConnectorArgs::from_str)
+            .transpose()?
+            .unwrap_or_default();
+
+        let os = open_os(&mut inventory, spec.connector.as_deref(), conn_args)?;
+
+        let mut process = match spec.pid {
+            Some(pid) => os.into_process_by_pid(pid)?,
+            None => os.into_process_by_name(&args.process_name)?,
+        };
+
+        let build = game_module_hashes(args, &mut process)?;
+
+        let target = OpenTarget { spec, process };
+
+        match builds.iter_mut().find(|(other, _)| *other == build) {
+            Some((_, targets)) => targets.push(target),
+            None => builds.push((build, vec![target])),
+        }
+    }
+
+    info!(
+        "dumping {} targets running {} distinct builds",
+        args.targets.len(),
+        builds.len()
+    );
+
+    let failed: usize = thread::scope(|s| {
+        let handles: Vec<_> = builds
+            .into_iter()
+            .map(|(_, targets)| s.spawn(move || dump_build(args, targets)))
+            .collect();
+
+        handles
+            .into_iter()
+            .map(|handle| handle.join().unwrap())
+            .sum()
+    });
+
+    if failed > 0 {
+        bail!(
+            "failed to dump {} of {} targets",
+            failed,
+            args.targets.len()
+        );
+    }
+
     Ok(())
 }
+
+/// Analyzes the first of several targets running the same build, and writes its result for all
+/// of them. Returns the number of targets that failed.
+fn dump_build(args: &Args, mut targets: Vec<OpenTarget>) -> usize {
+    let now = Instant::now();
+
+    let leader = &mut targets[0];
+    let leader_name = &leader.spec.name;
+
+    let result = match analyze(
+        args,
+        &mut leader.process,
+        &args.output.join(leader_name),
+        None,
+        None,
+    ) {
+        Ok(result) => result,
+        Err(err) => {
+            error!("failed to analyze {}: {}", leader_name, err);
+
+            return targets.len();
+        }
+    };
+
+    if targets.len() > 1 {
+        info!(
+            "reusing the analysis of {} for {} other targets",
+            leader_name,
+            targets.len() - 1
+        );
+    }
+
+    let mut failed = 0;
+
+    for target in &mut targets {
+        let out_dir = args.output.join(&target.spec.name);
+
+        if let Err(err) = write_output(args, &mut target.process, None, &out_dir, &result, None) {
+            error!("failed to dump {}: {}", target.spec.name, err);
+
+            failed += 1;
+        }
+    }
+
+    info!(
+        "dumped {} targets in {:.2?}",
+        targets.len() - failed,
+        now.elapsed()
+    );
+
+    failed
+}
+
+/// Returns the header hashes of the modules in the game directory, which identify the build a
+/// target runs. Other modules, like those of the OS, may differ between targets of the same build.
+fn game_module_hashes<P: Target>(args: &Args, process: &mut P) -> Result<BTreeMap<String, String>> {
+    let manifest = Manifest::new(
+        process,
+        &args.file_types,
+        &args.filter(),
+        args.indent_size,
+        args.schema_options(),
+    )?;
+
+    let modules = process.modules()?;
+
+    let normalize = |path: &str| path.replace('/', "\\").to_lowercase();
+
+    // The executable is in `game\bin\win64`, and all other game modules are further down `game`.
+    let game_dir = modules
+        .iter()
+        .find(|module| {
+            module
+                .name
+                .as_ref()
+                .eq_ignore_ascii_case(&args.process_name)
+        })
+        .and_then(|module| {
+            let path = normalize(module.path.as_ref());
+
+            path.rfind("\\bin\\").map(|i| path[..=i].to_string())
+        });
+
+    let Some(game_dir) = game_dir else {
+        return Ok(manifest.modules);
+    };
+
+    let game_modules: Vec<_> = modules
+        .iter()
+        .filter(|module| normalize(module.path.as_ref()).starts_with(&game_dir))
+        .map(|module| module.name.to_string())
+        .collect();
+
+    Ok(manifest
+        .modules
+        .into_iter()
+        .filter(|(name, _)| game_modules.contains(name))
+        .collect())
+}
+
+/// Keeps the process attached and dumps again whenever its module list changes. Modules that did
+/// not change since the previous dump reuse its results.
+///
+/// If the process exits, it is attached to again once it has been restarted. Every dump is
+/// published to the `--serve` server, if any.
+fn watch(
+    args: &Args,
+    os: OsInstanceArcBox<'static>,
+    mut process: IntoProcessInstanceArcBox<'static>,
+    interval: Duration,
+    server: Option<&Server>,
+) -> Result<()> {
+    let mut last: Option<(Vec<(String, Address, umem)>, Manifest, AnalysisResult)> = None;
+
+    loop {
+        if matches!(process.state(), ProcessState::Dead(_)) {
+            info!("process exited, waiting for it to restart");
+
+            process = loop {
+                thread::sleep(interval);
+
+                if let Ok(process) = os.clone().into_process_by_name(&args.process_name) {
+                    break process;
+                }
+            };
+        }
+
+        // The module list is cheap to read, and changes whenever a module is (re)loaded.
+        let modules = match process.module_list() {
+            Ok(modules) => modules
+                .into_iter()
+                .map(|module| (module.name.to_string(), module.base, module.size))
+                .collect(),
+            Err(err) => {
+                warn!("failed to read module list: {}", err);
+
+                thread::sleep(interval);
+
+                continue;
+            }
+        };
+
+        if last.as_ref().is_some_and(|(prev, _, _)| *prev == modules) {
+            thread::sleep(interval);
+
+            continue;
+        }
+
+        let manifest = match Manifest::new(
+            &mut process,
+            &args.file_types,
+            &args.filter(),
+            args.indent_size,
+            args.schema_options(),
+        ) {
+            Ok(manifest) => manifest,
+            Err(err) => {
+                warn!("failed to hash modules: {}", err);
+
+                thread::sleep(interval);
+
+                continue;
+            }
+        };
+
+        let baseline = match last.take() {
+            Some((_, prev, prev_result)) => {
+                manifest.baseline_from(&prev, prev_result, &args.output)
+            }
+            None if args.incremental => manifest.baseline(&args.output),
+            None => None,
+        };
+
+        let reused = baseline
+            .as_ref()
+            .map(|baseline| baseline.schemas.clone())
+            .unwrap_or_default();
+
+        match dump(
+            args,
+            &mut process,
+            args.incremental.then_some(&manifest),
+            baseline,
+            None,
+        ) {
+            Ok(result) => {
+                if let Some(server) = server {
+                    let build_number = output::read_build_number(&mut process, &result);
+
+                    server.publish(&result, build_number, &reused, &args.output, args.flatten);
+                }
+
+                last = Some((modules, manifest, result));
+            }
+            Err(err) => error!("failed to dump: {}", err),
+        }
+
+        thread::sleep(interval);
+    }
+}
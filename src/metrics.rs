@@ -0,0 +1,371 @@
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+use std::collections::BTreeMap;
+use std::fs;
+use std::mem;
+use std::path::Path;
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicBool, AtomicIsize, AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+use anyhow::{Result, bail};
+
+use serde_json::{Value, json};
+
+/// The number of buckets in the batch latency histogram. Bucket `i` counts the batches that took
+/// less than 2^i microseconds, and the last one counts everything slower.
+const LATENCY_BUCKETS: usize = 24;
+
+static NEXT_THREAD_ID: AtomicU64 = AtomicU64::new(1);
+
+#[global_allocator]
+static ALLOCATOR: TrackingAllocator = TrackingAllocator;
+
+static TRACKING: AtomicBool = AtomicBool::new(false);
+
+/// The heap bytes allocated minus those freed since [`track_memory`] was called. Memory that was
+/// allocated before and freed after makes this smaller than the actual usage.
+static HEAP_BYTES: AtomicIsize = AtomicIsize::new(0);
+static PEAK_HEAP_BYTES: AtomicIsize = AtomicIsize::new(0);
+
+thread_local! {
+    static THREAD_ID: Cell<u64> = const { Cell::new(0) };
+}
+
+/// Collects the timing of every stage of a run and the read traffic of every analyzer, for the
+/// `--metrics` option.
+pub struct Metrics {
+    start: Instant,
+    state: Mutex<MetricsState>,
+}
+
+#[derive(Default)]
+struct MetricsState {
+    memory_budget: Option<usize>,
+    reads: BTreeMap<&'static str, ReadStats>,
+    spans: Vec<SpanRecord>,
+}
+
+/// The reads made by a single stage, see [`Metered`](crate::target::Metered).
+#[derive(Default)]
+struct ReadStats {
+    batches: u64,
+    bytes: u64,
+    reads: u64,
+    time: Duration,
+    histogram: [u64; LATENCY_BUCKETS],
+}
+
+struct SpanRecord {
+    category: &'static str,
+    name: String,
+    start: Duration,
+    duration: Duration,
+    thread: u64,
+}
+
+/// Records the time from its creation until it is dropped as a span of [`Metrics`].
+pub struct Span<'a> {
+    metrics: &'a Metrics,
+    category: &'static str,
+    name: String,
+    start: Instant,
+}
+
+impl Metrics {
+    pub fn new() -> Self {
+        Self {
+            start: Instant::now(),
+            state: Mutex::default(),
+        }
+    }
+
+    /// Starts a span. Spans of the same category are shown side by side in the report.
+    pub fn span(&self, category: &'static str, name: impl Into<String>) -> Span<'_> {
+        Span {
+            metrics: self,
+            category,
+            name: name.into(),
+            start: Instant::now(),
+        }
+    }
+
+    /// Records a batch of `reads` reads totalling `bytes` bytes, made on behalf of `stage`.
+    pub fn record_reads(&self, stage: &'static str, reads: u64, bytes: u64, time: Duration) {
+        let bucket = (u64::BITS - (time.as_micros() as u64).leading_zeros()) as usize;
+
+        let mut state = self.state.lock().unwrap();
+
+        let stats = state.reads.entry(stage).or_default();
+
+        stats.batches += 1;
+        stats.bytes += bytes;
+        stats.reads += reads;
+        stats.time += time;
+        stats.histogram[bucket.min(LATENCY_BUCKETS - 1)] += 1;
+    }
+
+    /// Sets the `--max-memory` budget that the peak heap usage is reported against.
+    pub fn set_memory_budget(&self, bytes: usize) {
+        self.state.lock().unwrap().memory_budget = Some(bytes);
+    }
+
+    /// Writes everything recorded so far, either as a JSON report or as a Chrome trace that can
+    /// be loaded into `chrome://tracing` or Perfetto.
+    pub fn write(&self, file_path: &Path, format: &str) -> Result<()> {
+        let value = match format {
+            "report" => self.report(),
+            "trace" => self.trace(),
+            _ => bail!("unsupported metrics format: {}", format),
+        };
+
+        fs::write(file_path, serde_json::to_string_pretty(&value)?)?;
+
+        Ok(())
+    }
+
+    fn report(&self) -> Value {
+        let state = self.state.lock().unwrap();
+
+        let reads: serde_json::Map<_, _> = state
+            .reads
+            .iter()
+            .map(|(stage, stats)| (stage.to_string(), stats.to_json()))
+            .collect();
+
+        let mut spans: Vec<_> = state.spans.iter().collect();
+
+        spans.sort_by_key(|span| span.start);
+
+        let stages: Vec<_> = spans
+            .iter()
+            .map(|span| {
+                json!({
+                    "category": span.category,
+                    "name": span.name,
+                    "start_us": span.start.as_micros() as u64,
+                    "duration_us": span.duration.as_micros() as u64,
+                    "thread": span.thread,
+                })
+            })
+            .collect();
+
+        json!({
+            "duration_us": self.start.elapsed().as_micros() as u64,
+            "memory": memory_json(state.memory_budget, peak_memory()),
+            "reads": reads,
+            "stages": stages,
+        })
+    }
+
+    /// Builds a trace in the Chrome trace event format, with a complete event for every span.
+    fn trace(&self) -> Value {
+        let state = self.state.lock().unwrap();
+
+        let events: Vec<_> = state
+            .spans
+            .iter()
+            .map(|span| {
+                json!({
+                    "name": span.name,
+                    "cat": span.category,
+                    "ph": "X",
+                    "ts": span.start.as_micros() as u64,
+                    "dur": span.duration.as_micros() as u64,
+                    "pid": 1,
+                    "tid": span.thread,
+                })
+            })
+            .collect();
+
+        let reads: serde_json::Map<_, _> = state
+            .reads
+            .iter()
+            .map(|(stage, stats)| (stage.to_string(), stats.to_json()))
+            .collect();
+
+        json!({
+            "traceEvents": events,
+            "displayTimeUnit": "ms",
+            "otherData": { "memory": memory_json(state.memory_budget, peak_memory()), "reads": reads },
+        })
+    }
+}
+
+/// Starts counting the heap memory in use, for the `--metrics` report and the `--max-memory`
+/// budget. Until then, allocations aren't counted at all.
+pub fn track_memory() {
+    TRACKING.store(true, Ordering::Relaxed);
+}
+
+/// Returns the number of heap bytes in use, or 0 if [`track_memory`] wasn't called.
+pub fn memory_in_use() -> usize {
+    HEAP_BYTES.load(Ordering::Relaxed).max(0) as usize
+}
+
+/// Returns the highest number of heap bytes that were in use at once.
+pub fn peak_memory() -> usize {
+    PEAK_HEAP_BYTES.load(Ordering::Relaxed).max(0) as usize
+}
+
+fn memory_json(budget: Option<usize>, peak: usize) -> Value {
+    json!({
+        "budget_bytes": budget,
+        "exceeded": budget.is_some_and(|budget| peak > budget),
+        "peak_bytes": peak,
+    })
+}
+
+/// Forwards to the system allocator, and counts the bytes in use once tracking is enabled.
+struct TrackingAllocator;
+
+impl TrackingAllocator {
+    #[inline]
+    fn record(&self, delta: isize) {
+        if !TRACKING.load(Ordering::Relaxed) {
+            return;
+        }
+
+        let bytes = HEAP_BYTES.fetch_add(delta, Ordering::Relaxed) + delta;
+
+        if delta > 0 {
+            PEAK_HEAP_BYTES.fetch_max(bytes, Ordering::Relaxed);
+        }
+    }
+}
+
+unsafe impl GlobalAlloc for TrackingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        let ptr = unsafe { System.alloc(layout) };
+
+        if !ptr.is_null() {
+            self.record(layout.size() as isize);
+        }
+
+        ptr
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        let ptr = unsafe { System.alloc_zeroed(layout) };
+
+        if !ptr.is_null() {
+            self.record(layout.size() as isize);
+        }
+
+        ptr
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        unsafe { System.dealloc(ptr, layout) };
+
+        self.record(-(layout.size() as isize));
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        let new_ptr = unsafe { System.realloc(ptr, layout, new_size) };
+
+        if !new_ptr.is_null() {
+            self.record(new_size as isize - layout.size() as isize);
+        }
+
+        new_ptr
+    }
+}
+
+impl ReadStats {
+    fn to_json(&self) -> Value {
+        // Only the buckets that were hit are listed, keyed by their upper bound.
+        let histogram: Vec<_> = self
+            .histogram
+            .iter()
+            .enumerate()
+            .filter(|(_, count)| **count > 0)
+            .map(|(i, count)| {
+                let max_us = (i < LATENCY_BUCKETS - 1).then(|| 1u64 << i);
+
+                json!({ "max_us": max_us, "count": count })
+            })
+            .collect();
+
+        json!({
+            "batches": self.batches,
+            "reads": self.reads,
+            "bytes": self.bytes,
+            "time_us": self.time.as_micros() as u64,
+            "latency_histogram": histogram,
+        })
+    }
+}
+
+impl Drop for Span<'_> {
+    fn drop(&mut self) {
+        let thread = THREAD_ID.with(|id| {
+            if id.get() == 0 {
+                id.set(NEXT_THREAD_ID.fetch_add(1, Ordering::Relaxed));
+            }
+
+            id.get()
+        });
+
+        let record = SpanRecord {
+            category: self.category,
+            name: mem::take(&mut self.name),
+            start: self.start - self.metrics.start,
+            duration: self.start.elapsed(),
+            thread,
+        };
+
+        self.metrics.state.lock().unwrap().spans.push(record);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn latency_buckets() {
+        let metrics = Metrics::new();
+
+        for micros in [0, 1, 3, 4, 1 << 30] {
+            metrics.record_reads("offsets", 2, 16, Duration::from_micros(micros));
+        }
+
+        drop(metrics.span("analyze", "offsets"));
+
+        let report = metrics.report();
+        let reads = &report["reads"]["offsets"];
+
+        assert_eq!(reads["batches"], 5);
+        assert_eq!(reads["reads"], 10);
+        assert_eq!(reads["bytes"], 80);
+
+        // 0us, 1us, 2-3us, 4-7us and everything past the last bucket.
+        assert_eq!(
+            reads["latency_histogram"],
+            json!([
+                { "max_us": 1, "count": 1 },
+                { "max_us": 2, "count": 1 },
+                { "max_us": 4, "count": 1 },
+                { "max_us": 8, "count": 1 },
+                { "max_us": null, "count": 1 },
+            ])
+        );
+
+        assert_eq!(report["stages"][0]["name"], "offsets");
+    }
+
+    #[test]
+    fn memory_budget() {
+        // The peak is passed in, since turning on the global tracking here would count the
+        // allocations of the tests running alongside.
+        let memory = memory_json(Some(1 << 10), 1 << 20);
+
+        assert_eq!(memory["budget_bytes"], 1 << 10);
+        assert_eq!(memory["peak_bytes"], 1 << 20);
+        assert_eq!(memory["exceeded"], true);
+
+        assert_eq!(memory_json(Some(1 << 20), 1 << 10)["exceeded"], false);
+        assert_eq!(memory_json(None, 1 << 20)["exceeded"], false);
+    }
+}
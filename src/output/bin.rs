@@ -0,0 +1,428 @@
+use std::collections::{BTreeSet, HashMap};
+use std::io;
+
+use crate::analysis::*;
+
+pub const MAGIC: &[u8; 4] = b"CS2D";
+pub const VERSION: u32 = 2;
+
+const TABLE_COUNT: usize = 9;
+const HEADER_LEN: usize = 8 + (TABLE_COUNT + 1) * 8;
+
+const NO_STR: Str = Str(u32::MAX, 0);
+
+#[derive(Clone, Copy)]
+struct Str(u32, u32);
+
+#[derive(Default)]
+struct Tables<'a> {
+    strings: Vec<u8>,
+    string_map: HashMap<&'a str, Str>,
+    modules: Vec<u8>,
+    classes: Vec<u8>,
+    fields: Vec<u8>,
+    field_index: Vec<u8>,
+    metadata: Vec<u8>,
+    enums: Vec<u8>,
+    members: Vec<u8>,
+    entries: Vec<u8>,
+}
+
+impl<'a> Tables<'a> {
+    fn str(&mut self, s: &'a str) -> Str {
+        if let Some(s) = self.string_map.get(s) {
+            return *s;
+        }
+
+        let str = Str(self.strings.len() as u32, s.len() as u32);
+
+        self.strings.extend_from_slice(s.as_bytes());
+        self.strings.push(0);
+
+        self.string_map.insert(s, str);
+
+        str
+    }
+
+    /// Appends the entries sorted by name, and returns their range.
+    fn entries(&mut self, entries: impl IntoIterator<Item = (&'a str, u64)>) -> [u32; 2] {
+        let mut entries: Vec<_> = entries.into_iter().collect();
+
+        entries.sort_by(|(a, _), (b, _)| a.cmp(b));
+
+        let first = (self.entries.len() / 16) as u32;
+
+        for (name, value) in &entries {
+            let name = self.str(name);
+
+            push_str(&mut self.entries, name);
+            push_u64(&mut self.entries, *value);
+        }
+
+        [first, entries.len() as u32]
+    }
+
+    fn class(&mut self, class: ClassView<'a>) {
+        let name = self.str(class.name);
+        let parent = class.parent.map_or(NO_STR, |parent| self.str(parent));
+
+        let fields: Vec<_> = class.fields().collect();
+
+        let first_field = (self.fields.len() / 24) as u32;
+
+        for field in &fields {
+            let name = self.str(field.name);
+            let type_name = self.str(field.type_name);
+
+            push_str(&mut self.fields, name);
+            push_str(&mut self.fields, type_name);
+            push_u32(&mut self.fields, field.offset as u32);
+            push_u32(&mut self.fields, 0);
+        }
+
+        let mut field_index: Vec<_> = (0..fields.len() as u32).collect();
+
+        field_index.sort_by(|&a, &b| fields[a as usize].name.cmp(fields[b as usize].name));
+
+        let first_field_index = (self.field_index.len() / 4) as u32;
+
+        for i in field_index {
+            push_u32(&mut self.field_index, first_field + i);
+        }
+
+        let first_metadata = (self.metadata.len() / 24) as u32;
+        let metadata_count = class.metadata().len() as u32;
+
+        for metadata in class.metadata() {
+            let (kind, name, type_name) = match metadata {
+                MetadataView::Unknown { name } => (0, self.str(name), NO_STR),
+                MetadataView::NetworkChangeCallback { name } => (1, self.str(name), NO_STR),
+                MetadataView::NetworkVarNames { name, type_name } => {
+                    (2, self.str(name), self.str(type_name))
+                }
+            };
+
+            push_u32(&mut self.metadata, kind);
+            push_u32(&mut self.metadata, 0);
+            push_str(&mut self.metadata, name);
+            push_str(&mut self.metadata, type_name);
+        }
+
+        push_str(&mut self.classes, name);
+        push_str(&mut self.classes, parent);
+        push_range(&mut self.classes, [first_field, fields.len() as u32]);
+        push_range(&mut self.classes, [first_metadata, metadata_count]);
+        push_u32(&mut self.classes, first_field_index);
+        push_u32(&mut self.classes, 0);
+    }
+
+    fn enum_(&mut self, enum_: EnumView<'a>) {
+        let name = self.str(enum_.name);
+
+        let first_member = (self.members.len() / 16) as u32;
+        let member_count = enum_.members().len() as u32;
+
+        for member in enum_.members() {
+            let name = self.str(member.name);
+
+            push_str(&mut self.members, name);
+            push_u64(&mut self.members, member.value as u64);
+        }
+
+        push_str(&mut self.enums, name);
+        push_range(&mut self.enums, [first_member, member_count]);
+        push_u32(&mut self.enums, enum_.alignment as u32);
+        push_u32(&mut self.enums, member_count);
+    }
+}
+
+/// Writes the `bin` file type, a single file holding the complete analysis result.
+///
+/// The layout is designed to be memory-mapped and queried in place. All integers are
+/// little-endian, every table starts at an 8-byte aligned offset, and records have a fixed size:
+///
+/// ```text
+/// Header   { magic: [u8; 4] = "CS2D", version: u32, tables: [Range; 9], buttons: Range }
+/// Str      { offset: u32, len: u32 }       // Into the string table, NUL-terminated.
+/// Range    { first: u32, count: u32 }
+/// Entry    { name: Str, value: u64 }
+/// Module   { name: Str, classes: Range, enums: Range, offsets: Range, interfaces: Range }
+/// Class    { name: Str, parent: Str, fields: Range, metadata: Range, field_index: u32, pad: u32 }
+/// Field    { name: Str, type_name: Str, offset: i32, pad: u32 }
+/// Metadata { kind: u32, pad: u32, name: Str, type_name: Str }
+/// Enum     { name: Str, members: Range, alignment: u32, member_count: u32 }
+/// ```
+///
+/// The tables are, in order: strings (in bytes), modules, classes, fields, field indices,
+/// metadata, enums, enum members and entries. Modules are sorted by name, as are the classes and
+/// enums within a module, and the buttons, offsets and interfaces within their ranges. Fields are
+/// kept in declaration order, and `field_index` points to `fields.count` indices into the field
+/// table, sorted by field name. The `member_count` of an enum is its number of members, equal to
+/// `members.count`, and not a size in bytes. A missing parent has an offset of `u32::MAX`.
+pub fn write_bin(result: &AnalysisResult, out: &mut dyn io::Write) -> io::Result<()> {
+    let mut tables = Tables::default();
+
+    let buttons = tables.entries(
+        result
+            .buttons
+            .iter()
+            .map(|(name, value)| (name.as_str(), *value as u64)),
+    );
+
+    let module_names: BTreeSet<_> = result
+        .schemas
+        .modules()
+        .map(|module| module.name)
+        .chain(result.offsets.keys().map(String::as_str))
+        .chain(result.interfaces.keys().map(String::as_str))
+        .collect();
+
+    for module_name in module_names {
+        let name = tables.str(module_name);
+
+        let (classes, enums) = match result.schemas.module(module_name) {
+            Some(module) => {
+                let mut classes: Vec<_> = module.classes().collect();
+                let mut enums: Vec<_> = module.enums().collect();
+
+                classes.sort_by(|a, b| a.name.cmp(b.name));
+                enums.sort_by(|a, b| a.name.cmp(b.name));
+
+                (classes, enums)
+            }
+            None => (Vec::new(), Vec::new()),
+        };
+
+        let first_class = (tables.classes.len() / 40) as u32;
+
+        for &class in &classes {
+            tables.class(class);
+        }
+
+        let first_enum = (tables.enums.len() / 24) as u32;
+
+        for &enum_ in &enums {
+            tables.enum_(enum_);
+        }
+
+        let offsets = tables.entries(
+            result
+                .offsets
+                .get(module_name)
+                .into_iter()
+                .flatten()
+                .map(|(name, value)| (name.as_str(), *value as u64)),
+        );
+
+        let interfaces = tables.entries(
+            result
+                .interfaces
+                .get(module_name)
+                .into_iter()
+                .flatten()
+                .map(|(name, value)| (name.as_str(), *value as u64)),
+        );
+
+        push_str(&mut tables.modules, name);
+        push_range(&mut tables.modules, [first_class, classes.len() as u32]);
+        push_range(&mut tables.modules, [first_enum, enums.len() as u32]);
+        push_range(&mut tables.modules, offsets);
+        push_range(&mut tables.modules, interfaces);
+    }
+
+    let sections: [(&[u8], usize); TABLE_COUNT] = [
+        (&tables.strings, 1),
+        (&tables.modules, 40),
+        (&tables.classes, 40),
+        (&tables.fields, 24),
+        (&tables.field_index, 4),
+        (&tables.metadata, 24),
+        (&tables.enums, 24),
+        (&tables.members, 16),
+        (&tables.entries, 16),
+    ];
+
+    let mut header = Vec::with_capacity(HEADER_LEN);
+
+    header.extend_from_slice(MAGIC);
+    push_u32(&mut header, VERSION);
+
+    let mut offset = align(HEADER_LEN);
+
+    for (bytes, record_len) in &sections {
+        push_range(
+            &mut header,
+            [offset as u32, (bytes.len() / record_len) as u32],
+        );
+
+        offset = align(offset + bytes.len());
+    }
+
+    push_range(&mut header, buttons);
+
+    out.write_all(&header)?;
+
+    let mut written = header.len();
+
+    for (bytes, _) in &sections {
+        out.write_all(&[0; 8][..align(written) - written])?;
+        out.write_all(bytes)?;
+
+        written = align(written) + bytes.len();
+    }
+
+    Ok(())
+}
+
+#[inline]
+fn align(offset: usize) -> usize {
+    (offset + 7) & !7
+}
+
+#[inline]
+fn push_u32(buf: &mut Vec<u8>, value: u32) {
+    buf.extend_from_slice(&value.to_le_bytes());
+}
+
+#[inline]
+fn push_u64(buf: &mut Vec<u8>, value: u64) {
+    buf.extend_from_slice(&value.to_le_bytes());
+}
+
+#[inline]
+fn push_str(buf: &mut Vec<u8>, Str(offset, len): Str) {
+    push_u32(buf, offset);
+    push_u32(buf, len);
+}
+
+#[inline]
+fn push_range(buf: &mut Vec<u8>, [first, count]: [u32; 2]) {
+    push_u32(buf, first);
+    push_u32(buf, count);
+}
+
+#[cfg(test)]
+#[path = "../../readers/cs2_dumper_bin.rs"]
+mod reader;
+
+#[cfg(test)]
+mod tests {
+    use std::collections::BTreeMap;
+    use std::sync::Arc;
+
+    use super::reader::{Dump, Metadata};
+    use super::*;
+
+    #[test]
+    fn round_trip() -> io::Result<()> {
+        let network_var_names = ClassMetadata::NetworkVarNames {
+            name: Arc::from("m_vec"),
+            type_name: Arc::from("Vector"),
+        };
+
+        let result = AnalysisResult {
+            buttons: BTreeMap::from([("jump".to_string(), 0x10), ("attack".to_string(), 0x20)]),
+            filter: Filter::default(),
+            hints: HintMap::default(),
+            interfaces: BTreeMap::from([(
+                "engine2.dll".to_string(),
+                BTreeMap::from([("Source2EngineToClient001".to_string(), 0x30)]),
+            )]),
+            offsets: BTreeMap::from([(
+                "client.dll".to_string(),
+                BTreeMap::from([
+                    ("dwLocalPlayerPawn".to_string(), 0x40),
+                    ("dwEntityList".to_string(), 0x50),
+                ]),
+            )]),
+            schemas: [(
+                "client.dll".to_string(),
+                (
+                    vec![
+                        Class::new("client.dll", "C_BaseEntity")
+                            .with_parent(Some("CEntityInstance"))
+                            .with_metadata(vec![network_var_names.clone()])
+                            .with_fields([
+                                ("m_iHealth", "int32", 0x344),
+                                ("m_fFlags", "uint32", 0x3EC),
+                            ]),
+                        Class::new("client.dll", "CEntityInstance")
+                            .with_metadata(vec![network_var_names])
+                            .with_fields([("m_pEntity", "CEntityIdentity*", 0x10)]),
+                    ],
+                    vec![Enum {
+                        name: Arc::from("MoveType_t"),
+                        alignment: 1,
+                        size: 2,
+                        members: vec![
+                            EnumMember {
+                                name: Arc::from("MOVETYPE_NONE"),
+                                value: 0,
+                            },
+                            EnumMember {
+                                name: Arc::from("MOVETYPE_INVALID"),
+                                value: -1,
+                            },
+                        ],
+                    }],
+                ),
+            )]
+            .into_iter()
+            .collect(),
+        };
+
+        let mut buf = Vec::new();
+
+        write_bin(&result, &mut buf)?;
+
+        let dump = Dump::new(&buf).unwrap();
+
+        assert_eq!(dump.button("attack"), Some(0x20));
+        assert_eq!(dump.button("reload"), None);
+
+        let names: Vec<_> = dump.modules().map(|module| module.name()).collect();
+
+        assert_eq!(names, ["client.dll", "engine2.dll"]);
+
+        let engine = dump.module("engine2.dll").unwrap();
+
+        assert_eq!(engine.interface("Source2EngineToClient001"), Some(0x30));
+        assert_eq!(engine.classes().count(), 0);
+
+        let client = dump.module("client.dll").unwrap();
+
+        assert_eq!(client.offset("dwEntityList"), Some(0x50));
+
+        let entity = client.class("C_BaseEntity").unwrap();
+
+        assert_eq!(entity.parent(), Some("CEntityInstance"));
+        assert_eq!(client.class("CEntityInstance").unwrap().parent(), None);
+
+        let field = entity.field("m_iHealth").unwrap();
+
+        assert_eq!((field.type_name(), field.offset()), ("int32", 0x344));
+        assert!(entity.field("m_iMaxHealth").is_none());
+
+        // Fields keep their declaration order.
+        let fields: Vec<_> = entity.fields().map(|field| field.name()).collect();
+
+        assert_eq!(fields, ["m_iHealth", "m_fFlags"]);
+
+        assert_eq!(
+            entity.metadata().next(),
+            Some(Metadata::NetworkVarNames {
+                name: "m_vec",
+                type_name: "Vector",
+            })
+        );
+
+        let move_type = client.enum_("MoveType_t").unwrap();
+
+        assert_eq!(move_type.alignment(), 1);
+        assert_eq!(move_type.member_count(), 2);
+        assert_eq!(move_type.members().count(), 2);
+        assert_eq!(move_type.members().nth(1), Some(("MOVETYPE_INVALID", -1)));
+
+        Ok(())
+    }
+}
@@ -0,0 +1,400 @@
+use std::collections::{BTreeMap, HashMap};
+use std::fs;
+use std::io;
+use std::path::Path;
+use std::sync::Mutex;
+
+use anyhow::{Result, bail};
+
+use log::{debug, info};
+
+use serde::{Deserialize, Serialize};
+
+use super::{ContentHash, banner_lines, write_atomic};
+
+/// The name of the bundle in the output directory.
+pub const BUNDLE_FILE_NAME: &str = "cs2_dumper.bundle";
+
+const MAGIC: &[u8; 8] = b"CS2DBNDL";
+const VERSION: u32 = 2;
+
+/// Lists every file of a bundle together with the frame that holds its contents.
+#[derive(Debug, Default, Deserialize, Serialize)]
+struct Index {
+    files: BTreeMap<String, IndexEntry>,
+}
+
+#[derive(Debug, Deserialize, Serialize)]
+struct IndexEntry {
+    /// The [`ContentHash`] of the contents in hex, which skips the banner of files that have one.
+    hash: String,
+
+    /// The hash of the whole contents in hex, including the banner, by which files share frames.
+    full_hash: String,
+
+    /// The length of the contents.
+    len: u64,
+
+    /// The offset of the frame, counted from the end of the index.
+    offset: u64,
+
+    /// The length of the frame.
+    size: u64,
+}
+
+/// The zstd frame of the contents of one or more files.
+#[derive(Clone)]
+struct Frame {
+    len: u64,
+    data: Vec<u8>,
+}
+
+/// A bundle written by a previous run.
+struct Bundle {
+    index: Index,
+    data: Vec<u8>,
+    frames_start: usize,
+}
+
+impl Bundle {
+    fn read(file_path: &Path) -> Result<Self> {
+        let data = fs::read(file_path)?;
+
+        if data.len() < 16 || &data[..8] != MAGIC {
+            bail!("not a bundle");
+        }
+
+        let version = u32::from_le_bytes(data[8..12].try_into()?);
+
+        if version != VERSION {
+            bail!("unsupported bundle version: {}", version);
+        }
+
+        let index_len = u32::from_le_bytes(data[12..16].try_into()?) as usize;
+
+        let Some(index) = data.get(16..16 + index_len) else {
+            bail!("truncated bundle index");
+        };
+
+        Ok(Self {
+            index: serde_json::from_slice(index)?,
+            frames_start: 16 + index_len,
+            data,
+        })
+    }
+
+    /// Returns the frame of a file and the hash of its whole contents, if its contents had the
+    /// given hash.
+    fn frame(&self, file_name: &str, hash: u64) -> Option<(u64, Frame)> {
+        let entry = self
+            .index
+            .files
+            .get(file_name)
+            .filter(|entry| entry.hash == format!("{:016x}", hash))?;
+
+        let full_hash = u64::from_str_radix(&entry.full_hash, 16).ok()?;
+
+        let start = self.frames_start + entry.offset as usize;
+
+        Some((
+            full_hash,
+            Frame {
+                len: entry.len,
+                data: self.data.get(start..start + entry.size as usize)?.to_vec(),
+            },
+        ))
+    }
+}
+
+/// Collects every file of the output directory into a single archive, for the `--bundle` option.
+///
+/// The archive starts with a magic, a version and the length of a JSON [`Index`], followed by
+/// the index and the zstd frames. Every file is compressed on its own, so that it can be extracted
+/// without the others, and files with the same contents, banner included, share a frame. Files
+/// that are unchanged since the previous bundle reuse its frames instead of being compressed again.
+pub struct BundleWriter {
+    prev: Option<Bundle>,
+    state: Mutex<BundleState>,
+}
+
+#[derive(Default)]
+struct BundleState {
+    /// The [`ContentHash`] and the hash of the whole contents of every file.
+    files: BTreeMap<String, (u64, u64)>,
+
+    /// The frames by the hash of the whole contents.
+    frames: HashMap<u64, Frame>,
+
+    reused: usize,
+}
+
+impl BundleWriter {
+    pub fn new(out_dir: &Path) -> Self {
+        let prev = match Bundle::read(&out_dir.join(BUNDLE_FILE_NAME)) {
+            Ok(prev) => Some(prev),
+            Err(err) => {
+                debug!("not reusing the previous bundle: {}", err);
+
+                None
+            }
+        };
+
+        Self {
+            prev,
+            state: Mutex::default(),
+        }
+    }
+
+    /// Adds a file that was just written to `file_path`. Called by the workers that write the
+    /// files, so that compressing one file overlaps with generating the others.
+    pub fn add(&self, file_name: &str, hash: u64, file_path: &Path) -> Result<()> {
+        self.insert(file_name, hash, || fs::read(file_path))
+    }
+
+    /// Writes the bundle into `out_dir`, once all files have been added.
+    ///
+    /// Files in `out_dir` that weren't written by this run, e.g. those of type scopes that were
+    /// reused from the previous run, are added as well, so that the bundle always holds the whole
+    /// output directory.
+    pub fn finish(&self, out_dir: &Path) -> Result<()> {
+        for dir_entry in fs::read_dir(out_dir)? {
+            let dir_entry = dir_entry?;
+
+            let file_name = dir_entry.file_name().to_string_lossy().to_string();
+
+            if !dir_entry.file_type()?.is_file()
+                || file_name == BUNDLE_FILE_NAME
+                || file_name.ends_with(".tmp")
+                || self.state.lock().unwrap().files.contains_key(&file_name)
+            {
+                continue;
+            }
+
+            let contents = fs::read(dir_entry.path())?;
+
+            let file_type = file_name.rsplit_once('.').map_or("", |(_, ext)| ext);
+
+            let mut hash = ContentHash::new(banner_lines(file_type));
+
+            hash.update(&contents);
+
+            self.insert(&file_name, hash.hash, || Ok(contents))?;
+        }
+
+        let state = self.state.lock().unwrap();
+
+        // Frames are laid out in the order of the first file that refers to them.
+        let mut index = Index::default();
+        let mut offsets = HashMap::new();
+        let mut frames = Vec::new();
+        let mut frames_len = 0;
+
+        for (file_name, (hash, full_hash)) in &state.files {
+            let frame = &state.frames[full_hash];
+
+            let offset = *offsets.entry(*full_hash).or_insert_with(|| {
+                let offset = frames_len;
+
+                frames.push(frame);
+                frames_len += frame.data.len() as u64;
+
+                offset
+            });
+
+            index.files.insert(
+                file_name.clone(),
+                IndexEntry {
+                    hash: format!("{:016x}", hash),
+                    full_hash: format!("{:016x}", full_hash),
+                    len: frame.len,
+                    offset,
+                    size: frame.data.len() as u64,
+                },
+            );
+        }
+
+        let index = serde_json::to_vec(&index)?;
+
+        write_atomic(&out_dir.join(BUNDLE_FILE_NAME), |out| {
+            out.write_all(MAGIC)?;
+            out.write_all(&VERSION.to_le_bytes())?;
+            out.write_all(&(index.len() as u32).to_le_bytes())?;
+            out.write_all(&index)?;
+
+            for frame in &frames {
+                out.write_all(&frame.data)?;
+            }
+
+            Ok(())
+        })?;
+
+        info!(
+            "bundled {} files into {} frames ({} bytes), {} of them reused from the previous bundle",
+            state.files.len(),
+            frames.len(),
+            frames_len,
+            state.reused
+        );
+
+        Ok(())
+    }
+
+    /// Adds a file whose contents have the given hash. The contents are only read if the same file
+    /// in the previous bundle didn't have them, and only compressed if no other file has them.
+    ///
+    /// A file whose contents past the banner are unchanged since the previous bundle is unchanged on
+    /// disk as well, as [`write_changed`](super::write_changed) leaves it untouched, so that its
+    /// previous frame holds its banner, too.
+    fn insert<F>(&self, file_name: &str, hash: u64, read: F) -> Result<()>
+    where
+        F: FnOnce() -> io::Result<Vec<u8>>,
+    {
+        let prev = self
+            .prev
+            .as_ref()
+            .and_then(|prev| prev.frame(file_name, hash));
+
+        let reused = prev.is_some();
+
+        let (full_hash, frame) = match prev {
+            Some((full_hash, frame)) => (full_hash, Some(frame)),
+            None => {
+                let contents = read()?;
+
+                let mut full_hash = ContentHash::new(0);
+
+                full_hash.update(&contents);
+
+                let full_hash = full_hash.hash;
+
+                // Compressing happens outside of the lock, so that the workers compress in
+                // parallel.
+                let shared = self.state.lock().unwrap().frames.contains_key(&full_hash);
+
+                if shared {
+                    (full_hash, None)
+                } else {
+                    let frame = Frame {
+                        len: contents.len() as u64,
+                        data: zstd::encode_all(&contents[..], zstd::DEFAULT_COMPRESSION_LEVEL)?,
+                    };
+
+                    (full_hash, Some(frame))
+                }
+            }
+        };
+
+        let mut state = self.state.lock().unwrap();
+
+        state.files.insert(file_name.to_string(), (hash, full_hash));
+
+        state.reused += reused as usize;
+
+        if let Some(frame) = frame {
+            state.frames.entry(full_hash).or_insert(frame);
+        }
+
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::env;
+    use std::io::Read;
+    use std::process;
+
+    use super::*;
+
+    fn extract(bundle: &Bundle, file_name: &str) -> Result<String> {
+        let entry = &bundle.index.files[file_name];
+        let start = bundle.frames_start + entry.offset as usize;
+
+        let mut contents = String::new();
+
+        zstd::Decoder::new(&bundle.data[start..start + entry.size as usize])?
+            .read_to_string(&mut contents)?;
+
+        Ok(contents)
+    }
+
+    #[test]
+    fn dedup_and_reuse() -> Result<()> {
+        let out_dir = env::temp_dir().join(format!("cs2-dumper-bundle-{}", process::id()));
+
+        fs::create_dir_all(&out_dir)?;
+
+        fs::write(out_dir.join("a.json"), "{}")?;
+        fs::write(out_dir.join("b.json"), "{}")?;
+        fs::write(
+            out_dir.join("c.hpp"),
+            "// banner\n// 2025-01-01\n\nint x;\n",
+        )?;
+
+        let hash = |contents: &str, skip_lines| {
+            let mut hash = ContentHash::new(skip_lines);
+
+            hash.update(contents.as_bytes());
+
+            hash.hash
+        };
+
+        let bundle = BundleWriter::new(&out_dir);
+
+        bundle.add("a.json", hash("{}", 0), &out_dir.join("a.json"))?;
+        bundle.finish(&out_dir)?;
+
+        let prev = Bundle::read(&out_dir.join(BUNDLE_FILE_NAME))?;
+
+        // Both json files share a frame, and the one that wasn't added was picked up anyway.
+        let files = &prev.index.files;
+
+        assert_eq!(files.len(), 3);
+        assert_eq!(files["a.json"].offset, files["b.json"].offset);
+        assert_ne!(files["a.json"].offset, files["c.hpp"].offset);
+
+        assert_eq!(
+            extract(&prev, "c.hpp")?,
+            "// banner\n// 2025-01-01\n\nint x;\n"
+        );
+
+        // A file with the same contents but another banner gets a frame of its own.
+        let other = "// banner\n// 2025-03-01\n\nint x;\n";
+
+        fs::write(out_dir.join("d.hpp"), other)?;
+
+        let bundle = BundleWriter::new(&out_dir);
+
+        bundle.add("d.hpp", hash(other, 3), &out_dir.join("d.hpp"))?;
+        bundle.finish(&out_dir)?;
+
+        let prev = Bundle::read(&out_dir.join(BUNDLE_FILE_NAME))?;
+
+        let files = &prev.index.files;
+
+        assert_eq!(files["c.hpp"].hash, files["d.hpp"].hash);
+        assert_ne!(files["c.hpp"].offset, files["d.hpp"].offset);
+        assert_eq!(
+            extract(&prev, "c.hpp")?,
+            "// banner\n// 2025-01-01\n\nint x;\n"
+        );
+        assert_eq!(extract(&prev, "d.hpp")?, other);
+
+        fs::remove_file(out_dir.join("d.hpp"))?;
+
+        // A new banner alone doesn't change the hash, so the previous frame is reused.
+        let new = "// banner\n// 2025-02-01\n\nint x;\n";
+
+        fs::write(out_dir.join("c.hpp"), new)?;
+
+        let bundle = BundleWriter::new(&out_dir);
+
+        bundle.add("c.hpp", hash(new, 3), &out_dir.join("c.hpp"))?;
+
+        assert_eq!(bundle.state.lock().unwrap().reused, 1);
+
+        fs::remove_dir_all(&out_dir)?;
+
+        Ok(())
+    }
+}
@@ -36,13 +36,9 @@ impl CodeWriter for ButtonMap {
     }
 
     fn write_json(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
-        let content = {
-            let buttons: BTreeMap<_, _> = self.iter().map(|(name, value)| (name, value)).collect();
+        let content = BTreeMap::from([("client.dll", self)]);
 
-            BTreeMap::from_iter([("client.dll", buttons)])
-        };
-
-        fmt.write_str(&serde_json::to_string_pretty(&content).unwrap())
+        fmt.serialize_json(&content)
     }
 
     fn write_rs(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
@@ -0,0 +1,304 @@
+use std::collections::{BTreeMap, BTreeSet};
+use std::path::Path;
+
+use serde::{Deserialize, Serialize};
+
+use super::manifest::read_json;
+use super::{SchemaModule, SchemaOptions, slugify};
+
+use crate::analysis::*;
+
+/// Named values, e.g. the offsets of a module or the fields of a class.
+type Values = BTreeMap<String, i64>;
+
+/// What changed since the previous dump, as written to `delta.json`, so that consumers can patch
+/// their copy instead of fetching every file again.
+///
+/// Only the parts of the output that are written by the run are compared, so analyzers that were
+/// filtered out and schema modules that were reused from the previous run never show up.
+#[derive(Debug, Default, Serialize)]
+pub struct Delta {
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub buttons: BTreeMap<String, Changes>,
+
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub interfaces: BTreeMap<String, Changes>,
+
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub offsets: BTreeMap<String, Changes>,
+
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub schemas: BTreeMap<String, SchemaChanges>,
+}
+
+#[derive(Debug, Default, PartialEq, Serialize)]
+pub struct Changes {
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub added: Values,
+
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub moved: BTreeMap<String, Move>,
+
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub removed: Values,
+}
+
+#[derive(Debug, PartialEq, Serialize)]
+pub struct Move {
+    pub from: i64,
+    pub to: i64,
+}
+
+#[derive(Debug, Default, PartialEq, Serialize)]
+pub struct SchemaChanges {
+    #[serde(skip_serializing_if = "Vec::is_empty")]
+    pub added_classes: Vec<String>,
+
+    /// The field changes of every class, including all fields of the added and removed ones.
+    #[serde(skip_serializing_if = "BTreeMap::is_empty")]
+    pub classes: BTreeMap<String, Changes>,
+
+    #[serde(skip_serializing_if = "Vec::is_empty")]
+    pub removed_classes: Vec<String>,
+}
+
+/// The part of the `json` file of a schema module that is compared.
+#[derive(Deserialize)]
+struct JsonModule {
+    classes: BTreeMap<String, JsonClass>,
+}
+
+#[derive(Deserialize)]
+struct JsonClass {
+    fields: Values,
+}
+
+impl Delta {
+    /// Compares a result against the `json` files of the previous dump in `out_dir`. Files that
+    /// are missing or can't be parsed are treated as empty.
+    pub fn new(out_dir: &Path, result: &AnalysisResult, schema_options: SchemaOptions) -> Self {
+        let filter = &result.filter;
+
+        let mut delta = Self::default();
+
+        if filter.includes(Analyzer::Buttons) {
+            let new = BTreeMap::from([("client.dll".to_string(), values(&result.buttons))]);
+
+            delta.buttons = diff_modules(&read_prev(out_dir, "buttons.json"), &new);
+        }
+
+        if filter.includes(Analyzer::Interfaces) {
+            let new = result
+                .interfaces
+                .iter()
+                .map(|(module_name, ifaces)| (module_name.clone(), values(ifaces)))
+                .collect();
+
+            delta.interfaces = diff_modules(&read_prev(out_dir, "interfaces.json"), &new);
+        }
+
+        if filter.includes(Analyzer::Offsets) {
+            let new = result
+                .offsets
+                .iter()
+                .map(|(module_name, offsets)| (module_name.clone(), values(offsets)))
+                .collect();
+
+            delta.offsets = diff_modules(&read_prev(out_dir, "offsets.json"), &new);
+        }
+
+        for schemas in SchemaModule::iter(&result.schemas, schema_options) {
+            let module_name = schemas.module.name;
+
+            let prev = read_schema_fields(out_dir, module_name).unwrap_or_default();
+
+            // Built like the `json` file, where the last of any repeated name wins.
+            let new: BTreeMap<_, _> = schemas
+                .module
+                .classes()
+                .map(|class| {
+                    let fields = schemas
+                        .fields(class)
+                        .into_iter()
+                        .map(|(_, field)| (field.name.to_string(), field.offset as i64))
+                        .collect();
+
+                    (slugify(class.name), fields)
+                })
+                .collect();
+
+            let changes = SchemaChanges::new(&prev, &new);
+
+            if changes != SchemaChanges::default() {
+                delta.schemas.insert(module_name.to_string(), changes);
+            }
+        }
+
+        delta
+    }
+}
+
+impl Changes {
+    fn new(prev: &Values, new: &Values) -> Self {
+        let mut changes = Self::default();
+
+        for (name, &to) in new {
+            match prev.get(name) {
+                None => {
+                    changes.added.insert(name.clone(), to);
+                }
+                Some(&from) if from != to => {
+                    changes.moved.insert(name.clone(), Move { from, to });
+                }
+                _ => {}
+            }
+        }
+
+        for (name, &value) in prev {
+            if !new.contains_key(name) {
+                changes.removed.insert(name.clone(), value);
+            }
+        }
+
+        changes
+    }
+}
+
+impl SchemaChanges {
+    fn new(prev: &BTreeMap<String, Values>, new: &BTreeMap<String, Values>) -> Self {
+        let mut changes = Self::default();
+
+        let empty = Values::new();
+
+        for &class_name in &prev.keys().chain(new.keys()).collect::<BTreeSet<_>>() {
+            match (prev.get(class_name), new.get(class_name)) {
+                (None, Some(_)) => changes.added_classes.push(class_name.clone()),
+                (Some(_), None) => changes.removed_classes.push(class_name.clone()),
+                _ => {}
+            }
+
+            let fields = Changes::new(
+                prev.get(class_name).unwrap_or(&empty),
+                new.get(class_name).unwrap_or(&empty),
+            );
+
+            if fields != Changes::default() {
+                changes.classes.insert(class_name.clone(), fields);
+            }
+        }
+
+        changes
+    }
+}
+
+/// Compares the values of every module that is part of either dump.
+fn diff_modules(
+    prev: &BTreeMap<String, Values>,
+    new: &BTreeMap<String, Values>,
+) -> BTreeMap<String, Changes> {
+    let empty = Values::new();
+
+    prev.keys()
+        .chain(new.keys())
+        .collect::<BTreeSet<_>>()
+        .into_iter()
+        .filter_map(|module_name| {
+            let changes = Changes::new(
+                prev.get(module_name).unwrap_or(&empty),
+                new.get(module_name).unwrap_or(&empty),
+            );
+
+            (changes != Changes::default()).then(|| (module_name.clone(), changes))
+        })
+        .collect()
+}
+
+/// Reads the field offsets of every class from the `json` file of a schema module in `out_dir`,
+/// keyed by the class names as written there.
+pub fn read_schema_fields(out_dir: &Path, module_name: &str) -> Option<BTreeMap<String, Values>> {
+    let mut modules: BTreeMap<String, JsonModule> =
+        read_json(&out_dir.join(format!("{}.json", slugify(module_name))))?;
+
+    let classes = modules.remove(module_name)?.classes;
+
+    Some(
+        classes
+            .into_iter()
+            .map(|(class_name, class)| (class_name, class.fields))
+            .collect(),
+    )
+}
+
+fn read_prev(out_dir: &Path, file_name: &str) -> BTreeMap<String, Values> {
+    read_json(&out_dir.join(file_name)).unwrap_or_default()
+}
+
+fn values<V: Copy + TryInto<i64>>(map: &BTreeMap<String, V>) -> Values {
+    map.iter()
+        .filter_map(|(name, value)| Some((name.clone(), (*value).try_into().ok()?)))
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn entries(entries: &[(&str, i64)]) -> Values {
+        entries
+            .iter()
+            .map(|&(name, value)| (name.to_string(), value))
+            .collect()
+    }
+
+    #[test]
+    fn classes_and_fields() {
+        let prev = BTreeMap::from([
+            (
+                "C_BaseEntity".to_string(),
+                entries(&[("m_iHealth", 0x344), ("m_lifeState", 0x348)]),
+            ),
+            ("C_Removed".to_string(), entries(&[("m_nValue", 0x10)])),
+        ]);
+
+        let new = BTreeMap::from([
+            (
+                "C_BaseEntity".to_string(),
+                entries(&[("m_iHealth", 0x34C), ("m_iTeamNum", 0x3E3)]),
+            ),
+            ("C_Added".to_string(), entries(&[])),
+        ]);
+
+        let changes = SchemaChanges::new(&prev, &new);
+
+        assert_eq!(changes.added_classes, ["C_Added"]);
+        assert_eq!(changes.removed_classes, ["C_Removed"]);
+
+        assert_eq!(
+            changes.classes["C_BaseEntity"],
+            Changes {
+                added: entries(&[("m_iTeamNum", 0x3E3)]),
+                moved: BTreeMap::from([(
+                    "m_iHealth".to_string(),
+                    Move {
+                        from: 0x344,
+                        to: 0x34C
+                    }
+                )]),
+                removed: entries(&[("m_lifeState", 0x348)]),
+            }
+        );
+
+        assert_eq!(
+            changes.classes["C_Removed"].removed,
+            entries(&[("m_nValue", 0x10)])
+        );
+
+        // A class without fields only shows up in the list of added classes.
+        assert!(!changes.classes.contains_key("C_Added"));
+
+        // Unchanged modules are left out entirely.
+        let modules = BTreeMap::from([("client.dll".to_string(), entries(&[("dwEntityList", 1)]))]);
+
+        assert!(diff_modules(&modules, &modules).is_empty());
+    }
+}
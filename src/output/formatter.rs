@@ -1,17 +1,28 @@
 use std::fmt::{self, Write};
+use std::io;
+
+use anyhow::Result;
+
+use serde::Serialize;
+
+const SPACES: &str = "                                ";
 
 pub struct Formatter<'a> {
-    out: &'a mut String,
+    out: &'a mut dyn io::Write,
     indent_size: usize,
     indent_level: usize,
+    at_line_start: bool,
+    error: Option<io::Error>,
 }
 
 impl<'a> Formatter<'a> {
-    pub fn new(out: &'a mut String, indent_size: usize) -> Self {
+    pub fn new(out: &'a mut dyn io::Write, indent_size: usize) -> Self {
         Self {
             out,
             indent_size,
             indent_level: 0,
+            at_line_start: true,
+            error: None,
         }
     }
 
@@ -42,32 +53,93 @@ impl<'a> Formatter<'a> {
         Ok(())
     }
 
+    /// Serializes a value as pretty-printed JSON directly into the output. Errors are kept like I/O
+    /// errors of the other writes, so that [`Formatter::finish`] can surface them.
+    pub fn serialize_json<T: Serialize + ?Sized>(&mut self, value: &T) -> fmt::Result {
+        serde_json::to_writer_pretty(&mut *self, value).map_err(|err| {
+            self.error = Some(err.into());
+
+            fmt::Error
+        })
+    }
+
+    /// Converts the result of a formatting call, surfacing the underlying I/O error if the call
+    /// failed because of one.
+    pub fn finish(&mut self, result: fmt::Result) -> Result<()> {
+        match (result, self.error.take()) {
+            (_, Some(err)) => Err(err.into()),
+            (result, None) => Ok(result?),
+        }
+    }
+
     #[inline]
-    fn push_indentation(&mut self) {
-        if self.indent_level > 0 {
-            let indentation = " ".repeat(self.indent_level * self.indent_size);
+    fn push_indentation(&mut self) -> fmt::Result {
+        let mut len = self.indent_level * self.indent_size;
+
+        while len > 0 {
+            let n = len.min(SPACES.len());
+
+            self.push_str(&SPACES[..n])?;
 
-            self.out.push_str(&indentation);
+            len -= n;
         }
+
+        Ok(())
+    }
+
+    #[inline]
+    fn push_str(&mut self, s: &str) -> fmt::Result {
+        self.out.write_all(s.as_bytes()).map_err(|err| {
+            self.error = Some(err);
+
+            fmt::Error
+        })
     }
 }
 
 impl<'a> Write for Formatter<'a> {
     fn write_str(&mut self, s: &str) -> fmt::Result {
-        let mut lines = s.lines().peekable();
+        for line in s.split_inclusive('\n') {
+            // Line endings are normalized to `\n`, like `str::lines` does.
+            let (text, newline) = match line.strip_suffix('\n') {
+                Some(text) => (text.strip_suffix('\r').unwrap_or(text), true),
+                None => (line, false),
+            };
+
+            if !text.is_empty() {
+                if self.at_line_start {
+                    self.push_indentation()?;
+                }
 
-        while let Some(line) = lines.next() {
-            if self.out.ends_with('\n') && !line.is_empty() {
-                self.push_indentation();
+                self.push_str(text)?;
+
+                self.at_line_start = false;
             }
 
-            self.out.push_str(line);
+            if newline {
+                self.push_str("\n")?;
 
-            if lines.peek().is_some() || s.ends_with('\n') {
-                self.out.push('\n');
+                self.at_line_start = true;
             }
         }
 
         Ok(())
     }
 }
+
+/// Writes raw bytes, bypassing the indentation. Used to serialize JSON directly into the output.
+impl<'a> io::Write for Formatter<'a> {
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        let n = self.out.write(buf)?;
+
+        if n > 0 {
+            self.at_line_start = buf[n - 1] == b'\n';
+        }
+
+        Ok(n)
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        self.out.flush()
+    }
+}
@@ -1,4 +1,3 @@
-use std::collections::BTreeMap;
 use std::fmt::{self, Write};
 
 use heck::{AsPascalCase, AsSnakeCase};
@@ -64,17 +63,7 @@ impl CodeWriter for InterfaceMap {
     }
 
     fn write_json(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
-        let content: BTreeMap<_, _> = self
-            .iter()
-            .map(|(module_name, ifaces)| {
-                let ifaces: BTreeMap<_, _> =
-                    ifaces.iter().map(|(name, value)| (name, value)).collect();
-
-                (module_name, ifaces)
-            })
-            .collect();
-
-        fmt.write_str(&serde_json::to_string_pretty(&content).unwrap())
+        fmt.serialize_json(self)
     }
 
     fn write_rs(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
@@ -0,0 +1,558 @@
+use std::collections::{HashMap, HashSet};
+use std::fmt::{self, Write};
+
+use super::{Formatter, slugify};
+
+use crate::analysis::{ClassView, EnumView, FieldView, ModuleView};
+
+/// The schema types that are written as a builtin type, or as an array of one.
+const BUILTIN_TYPES: &[(&str, u32, &str, &str)] = &[
+    // Booleans are read as bytes in Rust, since any other value than 0 or 1 would be undefined
+    // behavior there.
+    ("bool", 1, "bool", "u8"),
+    ("char", 1, "char", "u8"),
+    ("float32", 4, "float", "f32"),
+    ("float64", 8, "double", "f64"),
+    ("int8", 1, "std::int8_t", "i8"),
+    ("int16", 2, "std::int16_t", "i16"),
+    ("int32", 4, "std::int32_t", "i32"),
+    ("int64", 8, "std::int64_t", "i64"),
+    ("uint8", 1, "std::uint8_t", "u8"),
+    ("uint16", 2, "std::uint16_t", "u16"),
+    ("uint32", 4, "std::uint32_t", "u32"),
+    ("uint64", 8, "std::uint64_t", "u64"),
+];
+
+/// Common engine types with a fixed layout, by the schema type they are stored as.
+const TYPE_ALIASES: &[(&str, &str)] = &[
+    ("CEntityHandle", "uint32"),
+    ("Color", "uint8[4]"),
+    ("GameTick_t", "int32"),
+    ("GameTime_t", "float32"),
+    ("QAngle", "float32[3]"),
+    ("Quaternion", "float32[4]"),
+    ("Vector", "float32[3]"),
+    ("Vector2D", "float32[2]"),
+    ("Vector4D", "float32[4]"),
+];
+
+/// The `repr(C)` struct of every class in a module, with explicit padding between the fields, so
+/// that consumers can read a whole object in one go.
+///
+/// Fields whose type is known are written with that type. All others, such as containers, are
+/// written as byte arrays spanning the space up to the next field. Classes are ordered so that
+/// every class comes after the classes it embeds.
+pub struct StructLayouts<'a> {
+    pub layouts: Vec<StructLayout<'a>>,
+}
+
+pub struct StructLayout<'a> {
+    pub class: ClassView<'a>,
+    pub members: Vec<Member<'a>>,
+}
+
+#[derive(Debug, PartialEq)]
+pub enum Member<'a> {
+    /// The parent class, embedded at offset 0.
+    Base(&'a str),
+
+    /// A field, with its type if it could be laid out, or as `len` opaque bytes.
+    Field {
+        field: FieldView<'a>,
+        ty: Option<FieldType<'a>>,
+        len: u32,
+    },
+
+    Padding {
+        offset: u32,
+        len: u32,
+    },
+}
+
+/// A field type with a known size and alignment, as spelled in each language.
+#[derive(Clone, Debug, PartialEq)]
+pub struct FieldType<'a> {
+    pub size: u32,
+    pub alignment: u32,
+    pub cpp: String,
+
+    /// The array extents written after the field name in C++, e.g. `[3]`.
+    pub cpp_extents: String,
+
+    pub rs: String,
+
+    /// The class embedded by value, if any.
+    pub class: Option<&'a str>,
+}
+
+/// The classes and enums of a module that field types can refer to.
+struct LocalTypes<'a> {
+    classes: HashMap<&'a str, ClassView<'a>>,
+    enums: HashMap<&'a str, EnumView<'a>>,
+}
+
+impl<'a> StructLayouts<'a> {
+    pub fn new(module: ModuleView<'a>) -> Self {
+        let mut types = LocalTypes {
+            classes: HashMap::new(),
+            enums: HashMap::new(),
+        };
+
+        // Classes of unknown size or alignment can't be laid out.
+        for class in module.classes() {
+            if class.size > 0 && class.alignment.is_power_of_two() {
+                types.classes.entry(class.name).or_insert(class);
+            }
+        }
+
+        for enum_ in module.enums() {
+            if matches!(enum_.alignment, 1 | 2 | 4 | 8) {
+                types.enums.entry(enum_.name).or_insert(enum_);
+            }
+        }
+
+        let layouts: Vec<_> = module
+            .classes()
+            .filter(|class| types.classes.get(class.name) == Some(class))
+            .map(|class| StructLayout::new(class, &types))
+            .collect();
+
+        let ids: HashMap<_, _> = layouts
+            .iter()
+            .enumerate()
+            .map(|(i, layout)| (layout.class.name, i))
+            .collect();
+
+        let mut order = Vec::with_capacity(layouts.len());
+        let mut visited = HashSet::new();
+
+        for i in 0..layouts.len() {
+            visit(i, &layouts, &ids, &mut visited, &mut order);
+        }
+
+        let mut layouts: Vec<_> = layouts.into_iter().map(Some).collect();
+
+        Self {
+            layouts: order
+                .into_iter()
+                .map(|i| layouts[i].take().unwrap())
+                .collect(),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.layouts.is_empty()
+    }
+
+    pub fn write_hpp(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
+        writeln!(fmt, "// Class layouts with explicit padding.")?;
+
+        fmt.block("namespace layouts", false, |fmt| {
+            for layout in &self.layouts {
+                let class = layout.class;
+                let name = slugify(class.name);
+
+                writeln!(fmt, "// Size: {:#X}", class.size)?;
+                writeln!(fmt, "// Alignment: {}", class.alignment)?;
+
+                fmt.block(
+                    &format!("struct alignas({}) {}", class.alignment, name),
+                    true,
+                    |fmt| {
+                        for member in &layout.members {
+                            match member {
+                                Member::Base(parent) => {
+                                    writeln!(fmt, "{} _base; // 0x0", slugify(parent))?
+                                }
+                                Member::Field {
+                                    field,
+                                    ty: Some(ty),
+                                    ..
+                                } => writeln!(
+                                    fmt,
+                                    "{} {}{}; // {:#X}: {}",
+                                    ty.cpp,
+                                    field.name,
+                                    ty.cpp_extents,
+                                    field.offset,
+                                    field.type_name
+                                )?,
+                                Member::Field {
+                                    field,
+                                    ty: None,
+                                    len,
+                                } => writeln!(
+                                    fmt,
+                                    "std::uint8_t {}[{:#X}]; // {:#X}: {}",
+                                    field.name, len, field.offset, field.type_name
+                                )?,
+                                Member::Padding { offset, len } => {
+                                    writeln!(fmt, "std::uint8_t pad_{:04X}[{:#X}];", offset, len)?
+                                }
+                            }
+                        }
+
+                        Ok(())
+                    },
+                )?;
+
+                writeln!(fmt, "static_assert(sizeof({}) == {:#X});", name, class.size)?;
+            }
+
+            Ok(())
+        })
+    }
+
+    pub fn write_rs(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
+        writeln!(fmt, "// Class layouts with explicit padding.")?;
+
+        fmt.block("pub mod layouts", false, |fmt| {
+            for layout in &self.layouts {
+                let class = layout.class;
+                let name = slugify(class.name);
+
+                writeln!(fmt, "// Size: {:#X}", class.size)?;
+                writeln!(fmt, "// Alignment: {}", class.alignment)?;
+                writeln!(fmt, "#[derive(Clone, Copy)]")?;
+
+                fmt.block(
+                    &format!(
+                        "#[repr(C, align({}))]\npub struct {}",
+                        class.alignment, name
+                    ),
+                    false,
+                    |fmt| {
+                        for member in &layout.members {
+                            match member {
+                                Member::Base(parent) => {
+                                    writeln!(fmt, "pub _base: {}, // 0x0", slugify(parent))?
+                                }
+                                Member::Field {
+                                    field,
+                                    ty: Some(ty),
+                                    ..
+                                } => writeln!(
+                                    fmt,
+                                    "pub {}: {}, // {:#X}: {}",
+                                    field.name, ty.rs, field.offset, field.type_name
+                                )?,
+                                Member::Field {
+                                    field,
+                                    ty: None,
+                                    len,
+                                } => writeln!(
+                                    fmt,
+                                    "pub {}: [u8; {:#X}], // {:#X}: {}",
+                                    field.name, len, field.offset, field.type_name
+                                )?,
+                                Member::Padding { offset, len } => {
+                                    writeln!(fmt, "pad_{:04X}: [u8; {:#X}],", offset, len)?
+                                }
+                            }
+                        }
+
+                        Ok(())
+                    },
+                )?;
+
+                writeln!(
+                    fmt,
+                    "const _: () = assert!(core::mem::size_of::<{}>() == {:#X});",
+                    name, class.size
+                )?;
+            }
+
+            Ok(())
+        })
+    }
+}
+
+/// Appends a layout to `order` after all of the layouts it embeds.
+fn visit(
+    i: usize,
+    layouts: &[StructLayout<'_>],
+    ids: &HashMap<&str, usize>,
+    visited: &mut HashSet<usize>,
+    order: &mut Vec<usize>,
+) {
+    if !visited.insert(i) {
+        return;
+    }
+
+    for dependency in layouts[i].dependencies() {
+        if let Some(&id) = ids.get(dependency) {
+            visit(id, layouts, ids, visited, order);
+        }
+    }
+
+    order.push(i);
+}
+
+impl<'a> StructLayout<'a> {
+    fn new(class: ClassView<'a>, types: &LocalTypes<'a>) -> Self {
+        let size = class.size as u32;
+        let alignment = class.alignment as u32;
+
+        let mut fields: Vec<_> = class
+            .fields()
+            .filter(|field| field.offset >= 0 && (field.offset as u32) < size)
+            .collect();
+
+        fields.sort_by_key(|field| field.offset);
+
+        let mut members = Vec::new();
+        let mut cursor = 0;
+
+        // The parent is only embedded if none of the fields were placed into its tail padding.
+        let parent = class
+            .parent_class()
+            .filter(|parent| types.classes.get(parent.name) == Some(parent));
+
+        if let Some(parent) = parent {
+            let end = fields.first().map_or(size, |field| field.offset as u32);
+
+            if parent.size as u32 <= end && parent.alignment <= class.alignment {
+                members.push(Member::Base(parent.name));
+
+                cursor = parent.size as u32;
+            }
+        }
+
+        for (i, &field) in fields.iter().enumerate() {
+            let offset = field.offset as u32;
+
+            // Fields that overlap the previous one, like bitfields sharing their storage, are left
+            // out.
+            if offset < cursor {
+                continue;
+            }
+
+            let end = fields[i + 1..]
+                .iter()
+                .map(|field| field.offset as u32)
+                .find(|&next| next > offset)
+                .unwrap_or(size);
+
+            if offset > cursor {
+                members.push(Member::Padding {
+                    offset: cursor,
+                    len: offset - cursor,
+                });
+            }
+
+            let ty = types.resolve(field.type_name).filter(|ty| {
+                ty.size <= end - offset && ty.alignment <= alignment && offset % ty.alignment == 0
+            });
+
+            let len = ty.as_ref().map_or(end - offset, |ty| ty.size);
+
+            members.push(Member::Field { field, ty, len });
+
+            cursor = offset + len;
+        }
+
+        if cursor < size {
+            members.push(Member::Padding {
+                offset: cursor,
+                len: size - cursor,
+            });
+        }
+
+        Self { class, members }
+    }
+
+    /// Returns the names of the classes embedded by value.
+    fn dependencies(&self) -> impl Iterator<Item = &'a str> + '_ {
+        self.members.iter().filter_map(|member| match member {
+            Member::Base(parent) => Some(*parent),
+            Member::Field { ty: Some(ty), .. } => ty.class,
+            _ => None,
+        })
+    }
+}
+
+impl<'a> LocalTypes<'a> {
+    /// Parses a schema type name, e.g. `CHandle<C_BaseEntity>`, `float32[3]` or `C_BaseEntity*`,
+    /// into a type that can be laid out. Returns `None` for types of unknown size.
+    fn resolve(&self, type_name: &'a str) -> Option<FieldType<'a>> {
+        // Pointers are only meaningful in the target process, so they are read as addresses.
+        if type_name.ends_with('*') {
+            return Some(FieldType::scalar(8, "std::uint64_t", "u64"));
+        }
+
+        if let Some(start) = array_start(type_name) {
+            let element = self.resolve(&type_name[..start])?;
+
+            // `T[2][3]` is an array of 2 arrays of 3 `T`.
+            let extents = type_name[start + 1..]
+                .strip_suffix(']')?
+                .split("][")
+                .map(|extent| extent.parse().ok())
+                .collect::<Option<Vec<u32>>>()?;
+
+            return element.array(&extents);
+        }
+
+        if let Some(&(_, size, cpp, rs)) =
+            BUILTIN_TYPES.iter().find(|(name, ..)| *name == type_name)
+        {
+            return Some(FieldType::scalar(size, cpp, rs));
+        }
+
+        if let Some(&(_, alias)) = TYPE_ALIASES.iter().find(|(name, _)| *name == type_name) {
+            return self.resolve(alias);
+        }
+
+        if type_name.starts_with("CHandle<") {
+            return self.resolve("uint32");
+        }
+
+        if let Some(enum_) = self.enums.get(type_name) {
+            // Enums are read as integers, since they may hold values that have no member.
+            let (cpp, rs) = match enum_.alignment {
+                1 => ("std::uint8_t", "u8"),
+                2 => ("std::uint16_t", "u16"),
+                4 => ("std::uint32_t", "u32"),
+                _ => ("std::uint64_t", "u64"),
+            };
+
+            return Some(FieldType::scalar(enum_.alignment as u32, cpp, rs));
+        }
+
+        let class = self.classes.get(type_name)?;
+
+        Some(FieldType {
+            size: class.size as u32,
+            alignment: class.alignment as u32,
+            cpp: slugify(class.name),
+            cpp_extents: String::new(),
+            rs: slugify(class.name),
+            class: Some(class.name),
+        })
+    }
+}
+
+impl<'a> FieldType<'a> {
+    fn scalar(size: u32, cpp: &str, rs: &str) -> Self {
+        Self {
+            size,
+            alignment: size,
+            cpp: cpp.to_string(),
+            cpp_extents: String::new(),
+            rs: rs.to_string(),
+            class: None,
+        }
+    }
+
+    fn array(self, extents: &[u32]) -> Option<Self> {
+        let count = extents
+            .iter()
+            .try_fold(1u32, |count, &extent| count.checked_mul(extent))?;
+
+        if count == 0 {
+            return None;
+        }
+
+        let cpp_extents = extents
+            .iter()
+            .map(|extent| format!("[{}]", extent))
+            .chain([self.cpp_extents])
+            .collect();
+
+        let rs = extents
+            .iter()
+            .rev()
+            .fold(self.rs, |rs, extent| format!("[{}; {}]", rs, extent));
+
+        Some(Self {
+            size: self.size.checked_mul(count)?,
+            alignment: self.alignment,
+            cpp: self.cpp,
+            cpp_extents,
+            rs,
+            class: self.class,
+        })
+    }
+}
+
+/// Returns the position of the first array extent that isn't part of a template argument.
+fn array_start(type_name: &str) -> Option<usize> {
+    let mut depth = 0;
+
+    for (i, c) in type_name.char_indices() {
+        match c {
+            '<' => depth += 1,
+            '>' => depth -= 1,
+            '[' if depth == 0 => return Some(i),
+            _ => {}
+        }
+    }
+
+    None
+}
+
+#[cfg(test)]
+mod tests {
+    use std::sync::Arc;
+
+    use super::*;
+
+    use crate::analysis::{Class, Enum, SchemaMap};
+
+    #[test]
+    fn pads_between_fields() {
+        let classes = vec![
+            Class::new("client.dll", "C_BasePlayerPawn")
+                .with_parent(Some("C_BaseEntity"))
+                .with_layout(8, 0x40)
+                .with_fields([
+                    ("m_iHealth", "int32", 0x10),
+                    ("m_vecOrigin", "Vector", 0x14),
+                    ("m_hOwner", "CHandle<C_BaseEntity>", 0x24),
+                    ("m_Items", "CUtlVector<int32>", 0x28),
+                    ("m_pNext", "C_BaseEntity*", 0x38),
+                ]),
+            Class::new("client.dll", "C_BaseEntity")
+                .with_layout(8, 0x10)
+                .with_fields([
+                    ("m_nFlags", "uint8[3]", 0x8),
+                    ("m_lifeState", "LifeState_t", 0xC),
+                ]),
+        ];
+
+        let enums = vec![Enum {
+            name: Arc::from("LifeState_t"),
+            alignment: 1,
+            size: 0,
+            members: Vec::new(),
+        }];
+
+        let schemas: SchemaMap = [("client.dll".to_string(), (classes, enums))]
+            .into_iter()
+            .collect();
+
+        let layouts = StructLayouts::new(schemas.module("client.dll").unwrap());
+
+        // The parent is embedded, so it has to come first.
+        let names: Vec<_> = layouts.layouts.iter().map(|l| l.class.name).collect();
+
+        assert_eq!(names, ["C_BaseEntity", "C_BasePlayerPawn"]);
+
+        let mut out = Vec::new();
+
+        layouts.write_rs(&mut Formatter::new(&mut out, 4)).unwrap();
+
+        let out = String::from_utf8(out).unwrap();
+
+        assert!(out.contains("pad_0000: [u8; 0x8],\n"));
+        assert!(out.contains("pub m_nFlags: [u8; 3], // 0x8: uint8[3]\n"));
+        assert!(out.contains("pad_000B: [u8; 0x1],\n"));
+        assert!(out.contains("pub m_lifeState: u8, // 0xC: LifeState_t\n"));
+        assert!(out.contains("pub _base: C_BaseEntity, // 0x0\n"));
+        assert!(out.contains("pub m_vecOrigin: [f32; 3], // 0x14: Vector\n"));
+        assert!(out.contains("pub m_hOwner: u32, // 0x24: CHandle<C_BaseEntity>\n"));
+        assert!(out.contains("pub m_Items: [u8; 0x10], // 0x28: CUtlVector<int32>\n"));
+        assert!(out.contains("pub m_pNext: u64, // 0x38: C_BaseEntity*\n"));
+        assert!(out.contains("size_of::<C_BasePlayerPawn>() == 0x40);"));
+    }
+}
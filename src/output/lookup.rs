@@ -0,0 +1,345 @@
+use std::cmp::Reverse;
+use std::collections::HashSet;
+use std::fmt::{self, Write};
+
+use super::Formatter;
+
+/// The average number of keys per bucket. Larger buckets make the seed array smaller, but take
+/// longer to place.
+const BUCKET_LEN: usize = 4;
+
+/// A minimal perfect hash table mapping `(class name, field name)` pairs to field offsets.
+///
+/// Every key is hashed with 64-bit FNV-1a, which selects a bucket. Each bucket stores a seed
+/// that, once mixed into the hash, sends all of its keys to distinct slots. Generated code only
+/// needs to repeat [`hash`] and [`slot`] to look up a key in O(1), without any startup work.
+pub struct LookupTable<'a> {
+    pub seeds: Vec<u32>,
+    pub entries: Vec<(String, &'a str, i32)>,
+}
+
+impl<'a> LookupTable<'a> {
+    pub fn new(keys: impl IntoIterator<Item = (String, &'a str, i32)>) -> Self {
+        let mut seen = HashSet::new();
+
+        // Duplicate keys could never be placed, so only the first occurrence of a key is kept.
+        // Field names that aren't valid identifiers are left out, since they would have to be
+        // escaped differently in every language.
+        let keys: Vec<_> = keys
+            .into_iter()
+            .filter(|(class_name, field_name, _)| {
+                !field_name.is_empty()
+                    && field_name
+                        .chars()
+                        .all(|c| c.is_ascii_alphanumeric() || c == '_')
+                    && seen.insert((class_name.clone(), *field_name))
+            })
+            .collect();
+
+        let bucket_count = keys.len().div_ceil(BUCKET_LEN).max(1);
+
+        let hashes: Vec<_> = keys
+            .iter()
+            .map(|(class_name, field_name, _)| hash(class_name, field_name))
+            .collect();
+
+        let mut buckets = vec![Vec::new(); bucket_count];
+
+        for (i, &h) in hashes.iter().enumerate() {
+            buckets[(h % bucket_count as u64) as usize].push(i);
+        }
+
+        // Placing the largest buckets first, while most slots are still free, keeps the search
+        // for their seeds short.
+        let mut order: Vec<_> = (0..bucket_count).collect();
+
+        order.sort_by_key(|&i| Reverse(buckets[i].len()));
+
+        let mut seeds = vec![0; bucket_count];
+        let mut slots = vec![None; keys.len()];
+        let mut taken = Vec::new();
+
+        for bucket_idx in order {
+            let bucket = &buckets[bucket_idx];
+
+            if bucket.is_empty() {
+                break;
+            }
+
+            'seeds: for seed in 0.. {
+                taken.clear();
+
+                for &key_idx in bucket {
+                    let slot = slot(hashes[key_idx], seed, keys.len());
+
+                    if slots[slot].is_some() || taken.contains(&slot) {
+                        continue 'seeds;
+                    }
+
+                    taken.push(slot);
+                }
+
+                for (&key_idx, &slot) in bucket.iter().zip(&taken) {
+                    slots[slot] = Some(key_idx);
+                }
+
+                seeds[bucket_idx] = seed;
+
+                break;
+            }
+        }
+
+        let mut keys: Vec<_> = keys.into_iter().map(Some).collect();
+
+        let entries = slots
+            .into_iter()
+            .map(|key_idx| keys[key_idx.unwrap()].take().unwrap())
+            .collect();
+
+        Self { seeds, entries }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    pub fn write_hpp(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
+        writeln!(fmt, "// Field offsets by class and field name.")?;
+
+        fmt.block("namespace lookup", false, |fmt| {
+            fmt.block("struct Entry", true, |fmt| {
+                writeln!(fmt, "std::string_view class_name;")?;
+                writeln!(fmt, "std::string_view field_name;")?;
+                writeln!(fmt, "std::ptrdiff_t offset;")
+            })?;
+
+            fmt.block("inline constexpr uint32_t seeds[] =", true, |fmt| {
+                self.write_seeds(fmt)
+            })?;
+
+            fmt.block("inline constexpr Entry entries[] =", true, |fmt| {
+                for (class_name, field_name, offset) in &self.entries {
+                    writeln!(
+                        fmt,
+                        "{{\"{}\", \"{}\", {}}},",
+                        class_name,
+                        field_name,
+                        SignedHex(*offset)
+                    )?;
+                }
+
+                Ok(())
+            })?;
+
+            fmt.block(
+                "constexpr uint64_t hash(std::string_view class_name, std::string_view field_name)",
+                false,
+                |fmt| {
+                    writeln!(fmt, "uint64_t h = 0xCBF29CE484222325;")?;
+                    writeln!(fmt, "for (char c : class_name) h = (h ^ uint8_t(c)) * 0x100000001B3;")?;
+                    writeln!(fmt, "h *= 0x100000001B3;")?;
+                    writeln!(fmt, "for (char c : field_name) h = (h ^ uint8_t(c)) * 0x100000001B3;")?;
+                    writeln!(fmt, "return h;")
+                },
+            )?;
+
+            fmt.block("constexpr size_t slot(uint64_t h, uint32_t seed)", false, |fmt| {
+                writeln!(fmt, "h ^= seed;")?;
+                writeln!(fmt, "h ^= h >> 33;")?;
+                writeln!(fmt, "h *= 0xFF51AFD7ED558CCD;")?;
+                writeln!(fmt, "h ^= h >> 33;")?;
+                writeln!(fmt, "h *= 0xC4CEB9FE1A85EC53;")?;
+                writeln!(fmt, "h ^= h >> 33;")?;
+                writeln!(fmt, "return h % std::size(entries);")
+            })?;
+
+            fmt.block(
+                "constexpr std::optional<std::ptrdiff_t> find(std::string_view class_name, std::string_view field_name)",
+                false,
+                |fmt| {
+                    writeln!(fmt, "const uint64_t h = hash(class_name, field_name);")?;
+                    writeln!(fmt, "const Entry& entry = entries[slot(h, seeds[h % std::size(seeds)])];")?;
+                    writeln!(fmt, "if (entry.class_name != class_name || entry.field_name != field_name) return std::nullopt;")?;
+                    writeln!(fmt, "return entry.offset;")
+                },
+            )
+        })
+    }
+
+    pub fn write_rs(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
+        writeln!(fmt, "// Field offsets by class and field name.")?;
+
+        fmt.block("pub mod lookup", false, |fmt| {
+            fmt.block("pub struct Entry", false, |fmt| {
+                writeln!(fmt, "pub class_name: &'static str,")?;
+                writeln!(fmt, "pub field_name: &'static str,")?;
+                writeln!(fmt, "pub offset: isize,")
+            })?;
+
+            // Statics, unlike consts, aren't copied when indexed at runtime. Const fns can read them
+            // since Rust 1.83.
+            writeln!(fmt, "pub static SEEDS: [u32; {}] = [", self.seeds.len())?;
+
+            fmt.indent(|fmt| self.write_seeds(fmt))?;
+
+            writeln!(fmt, "];")?;
+            writeln!(fmt, "pub static ENTRIES: [Entry; {}] = [", self.entries.len())?;
+
+            fmt.indent(|fmt| {
+                for (class_name, field_name, offset) in &self.entries {
+                    writeln!(
+                        fmt,
+                        "Entry {{ class_name: \"{}\", field_name: \"{}\", offset: {} }},",
+                        class_name,
+                        field_name,
+                        SignedHex(*offset)
+                    )?;
+                }
+
+                Ok(())
+            })?;
+
+            writeln!(fmt, "];")?;
+
+            fmt.block(
+                "pub const fn hash(class_name: &str, field_name: &str) -> u64",
+                false,
+                |fmt| {
+                    writeln!(fmt, "let (class_name, field_name) = (class_name.as_bytes(), field_name.as_bytes());")?;
+                    writeln!(fmt, "let mut h = 0xCBF29CE484222325u64;")?;
+                    writeln!(fmt, "let mut i = 0;")?;
+                    writeln!(fmt, "while i < class_name.len() {{ h = (h ^ class_name[i] as u64).wrapping_mul(0x100000001B3); i += 1; }}")?;
+                    writeln!(fmt, "h = h.wrapping_mul(0x100000001B3);")?;
+                    writeln!(fmt, "i = 0;")?;
+                    writeln!(fmt, "while i < field_name.len() {{ h = (h ^ field_name[i] as u64).wrapping_mul(0x100000001B3); i += 1; }}")?;
+                    writeln!(fmt, "h")
+                },
+            )?;
+
+            fmt.block("pub const fn slot(mut h: u64, seed: u32) -> usize", false, |fmt| {
+                writeln!(fmt, "h ^= seed as u64;")?;
+                writeln!(fmt, "h ^= h >> 33;")?;
+                writeln!(fmt, "h = h.wrapping_mul(0xFF51AFD7ED558CCD);")?;
+                writeln!(fmt, "h ^= h >> 33;")?;
+                writeln!(fmt, "h = h.wrapping_mul(0xC4CEB9FE1A85EC53);")?;
+                writeln!(fmt, "h ^= h >> 33;")?;
+                writeln!(fmt, "(h % ENTRIES.len() as u64) as usize")
+            })?;
+
+            // `str` comparisons aren't `const`, so names are compared byte by byte.
+            fmt.block("const fn str_eq(a: &str, b: &str) -> bool", false, |fmt| {
+                writeln!(fmt, "let (a, b) = (a.as_bytes(), b.as_bytes());")?;
+                writeln!(fmt, "if a.len() != b.len() {{ return false; }}")?;
+                writeln!(fmt, "let mut i = 0;")?;
+                writeln!(fmt, "while i < a.len() {{ if a[i] != b[i] {{ return false; }} i += 1; }}")?;
+                writeln!(fmt, "true")
+            })?;
+
+            fmt.block(
+                "pub const fn find(class_name: &str, field_name: &str) -> Option<isize>",
+                false,
+                |fmt| {
+                    writeln!(fmt, "let h = hash(class_name, field_name);")?;
+                    writeln!(fmt, "let entry = &ENTRIES[slot(h, SEEDS[(h % SEEDS.len() as u64) as usize])];")?;
+                    writeln!(fmt, "if !str_eq(entry.class_name, class_name) || !str_eq(entry.field_name, field_name) {{ return None; }}")?;
+                    writeln!(fmt, "Some(entry.offset)")
+                },
+            )
+        })
+    }
+
+    fn write_seeds(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
+        for chunk in self.seeds.chunks(16) {
+            let seeds: Vec<_> = chunk.iter().map(u32::to_string).collect();
+
+            writeln!(fmt, "{},", seeds.join(", "))?;
+        }
+
+        Ok(())
+    }
+}
+
+/// Formats an offset as a hex literal with a leading minus sign when it's negative, instead of
+/// its two's complement.
+struct SignedHex(i32);
+
+impl fmt::Display for SignedHex {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        if self.0 < 0 {
+            write!(f, "-{:#X}", self.0.unsigned_abs())
+        } else {
+            write!(f, "{:#X}", self.0)
+        }
+    }
+}
+
+/// 64-bit FNV-1a over both names, separated by a zero byte.
+pub fn hash(class_name: &str, field_name: &str) -> u64 {
+    let fold = |hash: u64, b: &u8| (hash ^ *b as u64).wrapping_mul(0x100000001b3);
+
+    let hash = class_name.as_bytes().iter().fold(0xcbf29ce484222325, fold);
+
+    field_name.as_bytes().iter().fold(fold(hash, &0), fold)
+}
+
+/// Mixes a bucket seed into a key hash with the MurmurHash3 finalizer and reduces it to a slot.
+pub fn slot(mut hash: u64, seed: u32, len: usize) -> usize {
+    hash ^= seed as u64;
+    hash ^= hash >> 33;
+    hash = hash.wrapping_mul(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash = hash.wrapping_mul(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+
+    (hash % len as u64) as usize
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::analysis::Class;
+
+    #[test]
+    fn every_key_finds_its_slot() {
+        let classes: Vec<_> = (0..200)
+            .map(|i| {
+                let fields: Vec<_> = (0..(i % 7))
+                    .map(|j| (format!("m_field{}", j), i * 0x10 + j))
+                    .collect();
+
+                Class::new("client.dll", &format!("C_Class{}", i)).with_fields(
+                    fields
+                        .iter()
+                        .map(|(name, offset)| (name.as_str(), "int32", *offset)),
+                )
+            })
+            .collect();
+
+        let table = LookupTable::new(classes.iter().flat_map(|class| {
+            class
+                .fields
+                .iter()
+                .map(|field| (class.name.to_string(), &*field.name, field.offset))
+        }));
+
+        let field_count: usize = classes.iter().map(|class| class.fields.len()).sum();
+
+        assert_eq!(table.entries.len(), field_count);
+
+        for class in &classes {
+            for field in &class.fields {
+                let h = hash(&class.name, &field.name);
+                let seed = table.seeds[(h % table.seeds.len() as u64) as usize];
+
+                let (class_name, field_name, offset) =
+                    &table.entries[slot(h, seed, table.entries.len())];
+
+                assert_eq!(
+                    (class_name.as_str(), *field_name, *offset),
+                    (&*class.name, &*field.name, field.offset)
+                );
+            }
+        }
+    }
+}
@@ -0,0 +1,169 @@
+use std::collections::{BTreeMap, BTreeSet};
+use std::fs;
+use std::path::Path;
+
+use anyhow::Result;
+
+use log::{debug, warn};
+
+use memflow::prelude::v1::*;
+
+use serde::de::DeserializeOwned;
+use serde::{Deserialize, Serialize};
+
+use super::{SchemaOptions, slugify};
+
+use crate::analysis::*;
+use crate::target::Target;
+
+/// The number of bytes hashed per module, which covers the PE headers including the section
+/// table.
+const HEADER_LEN: usize = 0x1000;
+
+/// Describes the contents of an output directory, so that a later run can tell which of its files
+/// are still up to date.
+#[derive(Clone, Debug, Default, Deserialize, Serialize)]
+pub struct Manifest {
+    pub build_number: u32,
+    pub file_types: Vec<String>,
+
+    /// The results of a filtered run only cover part of the analysis, so they can only be reused
+    /// by a run with the same filter.
+    #[serde(default)]
+    pub filter: Filter,
+
+    pub indent_size: usize,
+
+    #[serde(default)]
+    pub schema_options: SchemaOptions,
+
+    /// The header hash of every module loaded at the time of the dump.
+    pub modules: BTreeMap<String, String>,
+}
+
+impl Manifest {
+    pub fn new<P: Target>(
+        process: &mut P,
+        file_types: &[String],
+        filter: &Filter,
+        indent_size: usize,
+        schema_options: SchemaOptions,
+    ) -> Result<Self> {
+        let modules = process
+            .modules()?
+            .into_iter()
+            .filter_map(|module| {
+                let buf = process.read_raw(module.base, HEADER_LEN).data_part().ok()?;
+
+                Some((module.name.to_string(), format!("{:016x}", fnv1a(&buf))))
+            })
+            .collect();
+
+        Ok(Self {
+            build_number: 0,
+            file_types: file_types.to_vec(),
+            filter: filter.clone(),
+            indent_size,
+            modules,
+            schema_options,
+        })
+    }
+
+    pub fn load(out_dir: &Path) -> Option<Self> {
+        read_json(&out_dir.join("manifest.json"))
+    }
+
+    /// Compares this manifest against the one of a previous run in `out_dir`, and collects the
+    /// previous results that can be reused from its files.
+    ///
+    /// The PE headers contain the timestamp, checksum and section table of a module, so any
+    /// update to a module changes its hash.
+    pub fn baseline(&self, out_dir: &Path) -> Option<Baseline> {
+        let prev = Self::load(out_dir)?;
+
+        let mut baseline = self.compare(&prev, out_dir)?;
+
+        // The combined files can only be restored from their JSON representation.
+        if self.file_types.iter().any(|file_type| file_type == "json") {
+            baseline.buttons =
+                read_json::<BTreeMap<String, ButtonMap>>(&out_dir.join("buttons.json"))
+                    .and_then(|mut buttons| buttons.remove("client.dll"));
+
+            baseline.interfaces = read_json(&out_dir.join("interfaces.json"));
+            baseline.offsets = read_json(&out_dir.join("offsets.json"));
+        }
+
+        Some(baseline.without_empty())
+    }
+
+    /// Like [`Manifest::baseline`], but reuses the in-memory result of a previous run instead of
+    /// its files.
+    pub fn baseline_from(
+        &self,
+        prev: &Manifest,
+        prev_result: AnalysisResult,
+        out_dir: &Path,
+    ) -> Option<Baseline> {
+        let mut baseline = self.compare(prev, out_dir)?;
+
+        baseline.buttons = Some(prev_result.buttons);
+        baseline.interfaces = Some(prev_result.interfaces);
+        baseline.offsets = Some(prev_result.offsets);
+
+        Some(baseline.without_empty())
+    }
+
+    fn compare(&self, prev: &Manifest, out_dir: &Path) -> Option<Baseline> {
+        if prev.file_types != self.file_types
+            || prev.filter != self.filter
+            || prev.indent_size != self.indent_size
+            || prev.schema_options != self.schema_options
+        {
+            debug!("output settings changed since the previous run");
+
+            return None;
+        }
+
+        let modules: BTreeSet<_> = self
+            .modules
+            .iter()
+            .filter(|(name, hash)| prev.modules.get(*name) == Some(*hash))
+            .map(|(name, _)| name.clone())
+            .collect();
+
+        // Only type scopes whose files are all still present can be skipped. This is never the
+        // case with the `bin` file type, which has to include every type scope.
+        let schemas = modules
+            .iter()
+            .filter(|name| {
+                self.file_types.iter().all(|file_type| {
+                    out_dir
+                        .join(format!("{}.{}", slugify(name), file_type))
+                        .is_file()
+                })
+            })
+            .cloned()
+            .collect();
+
+        Some(Baseline {
+            modules,
+            schemas,
+            ..Default::default()
+        })
+    }
+}
+
+pub fn read_json<T: DeserializeOwned>(file_path: &Path) -> Option<T> {
+    let content = fs::read_to_string(file_path).ok()?;
+
+    serde_json::from_str(&content)
+        .inspect_err(|err| warn!("failed to parse {}: {}", file_path.display(), err))
+        .ok()
+}
+
+/// 64-bit FNV-1a, which unlike the standard library hasher is stable across releases.
+fn fnv1a(buf: &[u8]) -> u64 {
+    buf.iter().fold(0xcbf29ce484222325, |hash, &b| {
+        (hash ^ b as u64).wrapping_mul(0x100000001b3)
+    })
+}
@@ -1,8 +1,14 @@
+use std::ffi::OsString;
 use std::fmt::{self, Write};
-use std::fs;
-use std::path::Path;
+use std::fs::{self, File};
+use std::io::{self, BufRead, BufReader, BufWriter};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
 
-use anyhow::{Result, anyhow};
+use anyhow::{Result, bail};
+
+use log::debug;
 
 use chrono::{DateTime, Utc};
 
@@ -10,13 +16,28 @@ use memflow::prelude::v1::*;
 
 use serde_json::json;
 
+use bundle::{BUNDLE_FILE_NAME, BundleWriter};
+use delta::Delta;
 use formatter::Formatter;
+use schemas::SchemaModule;
+
+pub use delta::read_schema_fields;
+pub use manifest::Manifest;
+pub use schemas::SchemaOptions;
 
 use crate::analysis::*;
+use crate::metrics::{Metrics, Span};
+use crate::target::Target;
 
+mod bin;
+mod bundle;
 mod buttons;
+mod delta;
 mod formatter;
 mod interfaces;
+mod layout;
+mod lookup;
+mod manifest;
 mod offsets;
 mod schemas;
 
@@ -24,11 +45,11 @@ enum Item<'a> {
     Buttons(&'a ButtonMap),
     Interfaces(&'a InterfaceMap),
     Offsets(&'a OffsetMap),
-    Schemas(&'a SchemaMap),
+    Schemas(SchemaModule<'a>),
 }
 
 impl<'a> Item<'a> {
-    fn write(&self, fmt: &mut Formatter<'a>, file_type: &str) -> fmt::Result {
+    fn write(&self, fmt: &mut Formatter<'_>, file_type: &str) -> fmt::Result {
         match file_type {
             "cs" => self.write_cs(fmt),
             "hpp" => self.write_hpp(fmt),
@@ -84,104 +105,227 @@ impl<'a> CodeWriter for Item<'a> {
     }
 }
 
+/// The number of lines of the banner at the top of every file other than `json`.
+const BANNER_LINES: usize = 3;
+
 pub struct Output<'a> {
+    bundle: Option<BundleWriter>,
+    delta: bool,
     file_types: &'a [String],
     indent_size: usize,
+    jobs: usize,
+    manifest: Option<&'a Manifest>,
+    metrics: Option<&'a Metrics>,
     out_dir: &'a Path,
-    result: &'a AnalysisResult,
+    schema_options: SchemaOptions,
     timestamp: DateTime<Utc>,
 }
 
 impl<'a> Output<'a> {
     pub fn new(
+        bundle: bool,
+        delta: bool,
         file_types: &'a [String],
         indent_size: usize,
+        jobs: usize,
+        manifest: Option<&'a Manifest>,
+        metrics: Option<&'a Metrics>,
         out_dir: &'a Path,
-        result: &'a AnalysisResult,
+        schema_options: SchemaOptions,
     ) -> Result<Self> {
         fs::create_dir_all(&out_dir)?;
 
         Ok(Self {
+            bundle: bundle.then(|| BundleWriter::new(out_dir)),
+            delta,
             file_types,
             indent_size,
+            jobs: jobs.max(1),
+            manifest,
+            metrics,
             out_dir,
-            result,
+            schema_options,
             timestamp: Utc::now(),
         })
     }
 
-    pub fn dump_all<P: MemoryView + Process>(&self, process: &mut P) -> Result<()> {
-        let items = [
-            ("buttons", Item::Buttons(&self.result.buttons)),
-            ("interfaces", Item::Interfaces(&self.result.interfaces)),
-            ("offsets", Item::Offsets(&self.result.offsets)),
-        ];
+    pub fn dump_all<P: Target>(&self, process: &mut P, result: &AnalysisResult) -> Result<()> {
+        let filter = &result.filter;
+
+        process.set_stage("output");
+
+        // The previous files have to be read before they are replaced.
+        let delta = self
+            .delta
+            .then(|| Delta::new(self.out_dir, result, self.schema_options));
+
+        // The files of analyzers that were filtered out are left as they are.
+        let mut items: Vec<_> = [
+            (Analyzer::Buttons, "buttons", Item::Buttons(&result.buttons)),
+            (
+                Analyzer::Interfaces,
+                "interfaces",
+                Item::Interfaces(&result.interfaces),
+            ),
+            (Analyzer::Offsets, "offsets", Item::Offsets(&result.offsets)),
+        ]
+        .into_iter()
+        .filter(|(analyzer, _, _)| filter.includes(*analyzer))
+        .map(|(_, file_name, item)| (file_name.to_string(), item))
+        .collect();
+
+        items.extend(schema_items(&result.schemas, self.schema_options));
+
+        self.dump_items(&items)?;
+
+        // The binary format holds the complete result in a single file.
+        if self.file_types.iter().any(|file_type| file_type == "bin") {
+            let _span = self.span("cs2_dumper.bin");
+
+            self.write_file("cs2_dumper.bin", 0, |out| Ok(bin::write_bin(result, out)?))?;
+        }
+
+        if !result.hints.is_empty() {
+            let content = serde_json::to_string_pretty(&result.hints)?;
+
+            self.write_file(
+                "hints.json",
+                0,
+                |out| Ok(out.write_all(content.as_bytes())?),
+            )?;
+        }
+
+        if let Some(delta) = delta {
+            let content = serde_json::to_string_pretty(&delta)?;
 
-        for (file_name, item) in &items {
-            self.dump_item(file_name, item)?;
+            self.write_file(
+                "delta.json",
+                0,
+                |out| Ok(out.write_all(content.as_bytes())?),
+            )?;
         }
 
-        self.dump_schemas()?;
-        self.dump_info(process)?;
+        self.dump_info(process, result)?;
+
+        if let Some(bundle) = &self.bundle {
+            let _span = self.span(BUNDLE_FILE_NAME);
+
+            bundle.finish(self.out_dir)?;
+        }
 
         Ok(())
     }
 
-    fn dump_info<P: MemoryView + Process>(&self, process: &mut P) -> Result<()> {
-        let file_path = self.out_dir.join("info.json");
+    /// Writes the files of the given schema modules only, for the `--stream` option, which hands
+    /// the schemas over a few type scopes at a time before [`Output::dump_all`] writes the rest.
+    pub fn dump_schemas(&self, schemas: &SchemaMap) -> Result<()> {
+        self.dump_items(&schema_items(schemas, self.schema_options).collect::<Vec<_>>())
+    }
 
-        let build_number = self
-            .result
-            .offsets
+    /// Writes every item in every file type other than `bin`.
+    fn dump_items(&self, items: &[(String, Item)]) -> Result<()> {
+        // Every file is generated independently of the others, so the order in which they are
+        // written doesn't affect their contents.
+        let files: Vec<_> = items
             .iter()
-            .find_map(|(module_name, offsets)| {
-                let module = process.module_by_name(module_name).ok()?;
-                let offset = offsets.iter().find(|(name, _)| *name == "dwBuildNumber")?.1;
-
-                process.read::<u32>(module.base + offset).data_part().ok()
+            .flat_map(|(file_name, item)| {
+                self.file_types
+                    .iter()
+                    .filter(|file_type| *file_type != "bin")
+                    .map(move |file_type| (file_name, item, file_type))
             })
-            .ok_or(anyhow!("failed to read build number"))?;
+            .collect();
+
+        par_for_each(self.jobs, &files, |(file_name, item, file_type)| {
+            self.dump_file(file_name, item, file_type)
+        })
+    }
+
+    fn dump_info<P: Target>(&self, process: &mut P, result: &AnalysisResult) -> Result<()> {
+        let _span = self.span("info.json");
 
-        let content = serde_json::to_string_pretty(&json!({
-            "timestamp": self.timestamp.to_rfc3339(),
-            "build_number": build_number,
-        }))?;
+        let build_number = read_build_number(process, result);
 
-        fs::write(&file_path, &content)?;
+        // A filtered run might not have looked for the build number at all, in which case the
+        // previous info file is left in place.
+        let build_number = match build_number {
+            Some(build_number) => {
+                let content = serde_json::to_string_pretty(&json!({
+                    "timestamp": self.timestamp.to_rfc3339(),
+                    "build_number": build_number,
+                }))?;
+
+                self.write_file("info.json", 0, |out| Ok(out.write_all(content.as_bytes())?))?;
+
+                build_number
+            }
+            None if !result.filter.is_empty() => 0,
+            None => bail!("failed to read build number"),
+        };
+
+        if let Some(manifest) = self.manifest {
+            let content = serde_json::to_string_pretty(&Manifest {
+                build_number,
+                ..manifest.clone()
+            })?;
+
+            self.write_file("manifest.json", 0, |out| {
+                Ok(out.write_all(content.as_bytes())?)
+            })?;
+        }
 
         Ok(())
     }
 
-    fn dump_item(&self, file_name: &str, item: &Item) -> Result<()> {
-        for file_type in self.file_types {
-            let mut out = String::new();
-            let mut fmt = Formatter::new(&mut out, self.indent_size);
+    fn dump_file(&self, file_name: &str, item: &Item, file_type: &str) -> Result<()> {
+        let file_name = format!("{}.{}", file_name, file_type);
 
-            if file_type != "json" {
-                self.write_banner(&mut fmt)?;
-            }
+        let _span = self.span(file_name.as_str());
+
+        // The banner holds the time of the dump, so it is left out when comparing the contents.
+        let written = self.write_file(&file_name, banner_lines(file_type), |out| {
+            let mut fmt = Formatter::new(out, self.indent_size);
 
-            item.write(&mut fmt, file_type)?;
+            let result = if file_type != "json" {
+                self.write_banner(&mut fmt)
+                    .and_then(|_| item.write(&mut fmt, file_type))
+            } else {
+                item.write(&mut fmt, file_type)
+            };
 
-            let file_path = self.out_dir.join(format!("{}.{}", file_name, file_type));
+            fmt.finish(result)
+        })?;
 
-            fs::write(&file_path, out)?;
+        if !written {
+            debug!("{} is unchanged", self.out_dir.join(file_name).display());
         }
 
         Ok(())
     }
 
-    fn dump_schemas(&self) -> Result<()> {
-        for (module_name, (classes, enums)) in &self.result.schemas {
-            let map = SchemaMap::from([(module_name.clone(), (classes.clone(), enums.clone()))]);
+    /// Writes a file of the output directory with [`write_changed`], and adds it to the bundle if
+    /// enabled. Returns whether the file was replaced.
+    fn write_file<F>(&self, file_name: &str, skip_lines: usize, f: F) -> Result<bool>
+    where
+        F: FnOnce(&mut dyn io::Write) -> Result<()>,
+    {
+        let file_path = self.out_dir.join(file_name);
 
-            self.dump_item(&slugify(&module_name), &Item::Schemas(&map))?;
+        let (replaced, hash) = write_changed(&file_path, skip_lines, f)?;
+
+        if let Some(bundle) = &self.bundle {
+            bundle.add(file_name, hash, &file_path)?;
         }
 
-        Ok(())
+        Ok(replaced)
     }
 
-    fn write_banner(&self, fmt: &mut Formatter<'_>) -> Result<()> {
+    /// Starts a span of the `--metrics` report for writing a file, if enabled.
+    fn span(&self, file_name: &str) -> Option<Span<'_>> {
+        self.metrics.map(|metrics| metrics.span("dump", file_name))
+    }
+
+    fn write_banner(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
         writeln!(fmt, "// Generated using https://github.com/a2x/cs2-dumper")?;
         writeln!(fmt, "// {}\n", self.timestamp)?;
 
@@ -189,7 +333,476 @@ impl<'a> Output<'a> {
     }
 }
 
+fn schema_items(
+    schemas: &SchemaMap,
+    options: SchemaOptions,
+) -> impl Iterator<Item = (String, Item<'_>)> {
+    SchemaModule::iter(schemas, options)
+        .map(|schemas| (slugify(schemas.module.name), Item::Schemas(schemas)))
+}
+
+/// Reads the build number of the game through the `dwBuildNumber` offset of a result, if it was
+/// found.
+pub fn read_build_number<P: Target>(process: &mut P, result: &AnalysisResult) -> Option<u32> {
+    result
+        .offsets
+        .iter()
+        .find_map(|(module_name, offsets)| {
+            let module = process.module(module_name).ok()?;
+            let offset = offsets.iter().find(|(name, _)| *name == "dwBuildNumber")?.1;
+
+            process.read::<u32>(module.base + offset).data_part().ok()
+        })
+        .filter(|&build_number| build_number != 0)
+}
+
+/// Reads the pattern locations written by the previous run into `out_dir`. Without any, every
+/// pattern is searched for in the whole image.
+pub fn read_hints(out_dir: &Path) -> HintMap {
+    fs::read_to_string(out_dir.join("hints.json"))
+        .ok()
+        .and_then(|content| serde_json::from_str(&content).ok())
+        .unwrap_or_default()
+}
+
+/// Runs `f` for every item on up to `jobs` worker threads. If any calls fail, the error of the
+/// first failing item is returned.
+fn par_for_each<I, F>(jobs: usize, items: &[I], f: F) -> Result<()>
+where
+    I: Sync,
+    F: Fn(&I) -> Result<()> + Sync,
+{
+    let workers = jobs.min(items.len());
+
+    if workers <= 1 {
+        return items.iter().try_for_each(f);
+    }
+
+    let next = AtomicUsize::new(0);
+
+    let mut results: Vec<_> = thread::scope(|s| {
+        let handles: Vec<_> = (0..workers)
+            .map(|_| {
+                let next = &next;
+                let f = &f;
+
+                s.spawn(move || {
+                    let mut results = Vec::new();
+
+                    loop {
+                        let i = next.fetch_add(1, Ordering::Relaxed);
+
+                        let Some(item) = items.get(i) else {
+                            break;
+                        };
+
+                        if let Err(err) = f(item) {
+                            results.push((i, err));
+                        }
+                    }
+
+                    results
+                })
+            })
+            .collect();
+
+        handles
+            .into_iter()
+            .flat_map(|handle| handle.join().unwrap())
+            .collect()
+    });
+
+    results.sort_unstable_by_key(|(i, _)| *i);
+
+    match results.into_iter().next() {
+        Some((_, err)) => Err(err),
+        None => Ok(()),
+    }
+}
+
+/// Streams a file into a temporary file next to it, which then replaces the destination in a
+/// single rename. Readers therefore never observe a partially written file.
+fn write_atomic<F>(file_path: &Path, f: F) -> Result<()>
+where
+    F: FnOnce(&mut dyn io::Write) -> Result<()>,
+{
+    write_changed(file_path, 0, f)?;
+
+    Ok(())
+}
+
+/// Like [`write_atomic`], but leaves the destination untouched if its contents, past the first
+/// `skip_lines` lines, are the same as the new ones. Returns whether the file was replaced, and
+/// the [`ContentHash`] of the new contents.
+///
+/// Unchanged files thus keep their modification time, and don't have to be synced again.
+fn write_changed<F>(file_path: &Path, skip_lines: usize, f: F) -> Result<(bool, u64)>
+where
+    F: FnOnce(&mut dyn io::Write) -> Result<()>,
+{
+    let mut tmp_path = OsString::from(file_path);
+    tmp_path.push(".tmp");
+
+    let tmp_path = PathBuf::from(tmp_path);
+
+    let mut hash = ContentHash::new(skip_lines);
+
+    let result = File::create(&tmp_path)
+        .map_err(Into::into)
+        .and_then(|file| {
+            let mut out = HashWriter {
+                out: BufWriter::new(file),
+                hash: &mut hash,
+            };
+
+            f(&mut out)?;
+
+            out.out.into_inner().map_err(|err| err.into_error())?;
+
+            Ok(())
+        })
+        .and_then(|_| {
+            if same_contents(file_path, &tmp_path, skip_lines).unwrap_or(false) {
+                fs::remove_file(&tmp_path)?;
+
+                return Ok((false, hash.hash));
+            }
+
+            fs::rename(&tmp_path, file_path)?;
+
+            Ok((true, hash.hash))
+        });
+
+    if result.is_err() {
+        let _ = fs::remove_file(&tmp_path);
+    }
+
+    result
+}
+
+/// Compares two files past their first `skip_lines` lines, a buffer at a time.
+fn same_contents(a: &Path, b: &Path, skip_lines: usize) -> io::Result<bool> {
+    let mut a = BufReader::new(File::open(a)?);
+    let mut b = BufReader::new(File::open(b)?);
+
+    for _ in 0..skip_lines {
+        a.skip_until(b'\n')?;
+        b.skip_until(b'\n')?;
+    }
+
+    loop {
+        let a_buf = a.fill_buf()?;
+        let b_buf = b.fill_buf()?;
+
+        if a_buf.is_empty() || b_buf.is_empty() {
+            return Ok(a_buf.is_empty() && b_buf.is_empty());
+        }
+
+        let len = a_buf.len().min(b_buf.len());
+
+        if a_buf[..len] != b_buf[..len] {
+            return Ok(false);
+        }
+
+        a.consume(len);
+        b.consume(len);
+    }
+}
+
+/// Returns the number of lines of the banner at the top of files of the given type.
 #[inline]
-fn slugify(input: &str) -> String {
+fn banner_lines(file_type: &str) -> usize {
+    match file_type {
+        "bin" | "json" => 0,
+        _ => BANNER_LINES,
+    }
+}
+
+/// A 64-bit FNV-1a hash of everything past the first `skip_lines` lines of a file.
+struct ContentHash {
+    hash: u64,
+    skip_lines: usize,
+}
+
+impl ContentHash {
+    fn new(skip_lines: usize) -> Self {
+        Self {
+            hash: 0xcbf29ce484222325,
+            skip_lines,
+        }
+    }
+
+    fn update(&mut self, buf: &[u8]) {
+        let mut buf = buf;
+
+        while self.skip_lines > 0 {
+            let Some(end) = buf.iter().position(|&b| b == b'\n') else {
+                return;
+            };
+
+            buf = &buf[end + 1..];
+
+            self.skip_lines -= 1;
+        }
+
+        for &b in buf {
+            self.hash = (self.hash ^ b as u64).wrapping_mul(0x100000001b3);
+        }
+    }
+}
+
+/// Hashes everything that is written through it.
+struct HashWriter<'a, W> {
+    out: W,
+    hash: &'a mut ContentHash,
+}
+
+impl<W: io::Write> io::Write for HashWriter<'_, W> {
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        let n = self.out.write(buf)?;
+
+        self.hash.update(&buf[..n]);
+
+        Ok(n)
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        self.out.flush()
+    }
+}
+
+#[inline]
+pub fn slugify(input: &str) -> String {
     input.replace(|c: char| !c.is_alphanumeric(), "_")
 }
+
+#[cfg(test)]
+mod tests {
+    use std::sync::Arc;
+    use std::time::Instant;
+
+    use serde_json::Value;
+
+    use crate::target::Replay;
+
+    use super::*;
+
+    fn str_value(value: &Value, key: &str) -> Arc<str> {
+        Arc::from(value.get(key).and_then(Value::as_str).unwrap_or_default())
+    }
+
+    #[test]
+    fn banner_is_not_hashed() {
+        let hash = |content: &str, chunk_len: usize| {
+            let mut hash = ContentHash::new(BANNER_LINES);
+
+            for chunk in content.as_bytes().chunks(chunk_len) {
+                hash.update(chunk);
+            }
+
+            hash.hash
+        };
+
+        let prev = "// Generated using https://github.com/a2x/cs2-dumper\n// 2025-01-01\n\nX = 1\n";
+        let new = "// Generated using https://github.com/a2x/cs2-dumper\n// 2025-02-01\n\nX = 1\n";
+
+        // The result doesn't depend on how the contents are split up either.
+        assert_eq!(hash(prev, 1), hash(new, 7));
+        assert_ne!(hash(prev, 1), hash(&new.replace("1\n", "2\n"), 1));
+
+        let dir = std::env::temp_dir().join(format!("cs2-dumper-same-{}", std::process::id()));
+
+        fs::create_dir_all(&dir).unwrap();
+
+        let [a, b, c] = ["a", "b", "c"].map(|name| dir.join(name));
+
+        fs::write(&a, prev).unwrap();
+        fs::write(&b, new).unwrap();
+        fs::write(&c, new.replace("1\n", "1\n\n")).unwrap();
+
+        assert!(same_contents(&a, &b, BANNER_LINES).unwrap());
+        assert!(!same_contents(&a, &b, 0).unwrap());
+        assert!(!same_contents(&b, &c, BANNER_LINES).unwrap());
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    /// Rebuilds a schema map from a checked-in JSON file. The JSON doesn't include field types,
+    /// so these are left empty.
+    fn load_schemas(module_name: &str) -> Option<SchemaMap> {
+        let content = fs::read_to_string(format!("output/{}.json", slugify(module_name))).ok()?;
+        let value: Value = serde_json::from_str(&content).ok()?;
+
+        let module = value.get(module_name)?;
+
+        let classes = module
+            .get("classes")?
+            .as_object()?
+            .iter()
+            .map(|(name, class)| {
+                let metadata = class
+                    .get("metadata")
+                    .and_then(Value::as_array)
+                    .into_iter()
+                    .flatten()
+                    .map(|metadata| {
+                        let name = str_value(metadata, "name");
+
+                        match metadata.get("type").and_then(Value::as_str) {
+                            Some("NetworkChangeCallback") => {
+                                ClassMetadata::NetworkChangeCallback { name }
+                            }
+                            Some("NetworkVarNames") => ClassMetadata::NetworkVarNames {
+                                name,
+                                type_name: str_value(metadata, "type_name"),
+                            },
+                            _ => ClassMetadata::Unknown { name },
+                        }
+                    })
+                    .collect();
+
+                let fields = class
+                    .get("fields")
+                    .and_then(Value::as_object)
+                    .into_iter()
+                    .flatten()
+                    .map(|(name, offset)| {
+                        (name.as_str(), "", offset.as_i64().unwrap_or_default() as i32)
+                    });
+
+                Class::new(module_name, name)
+                    .with_parent(class.get("parent").and_then(Value::as_str))
+                    .with_metadata(metadata)
+                    .with_fields(fields)
+            })            .collect();
+
+        let enums = module
+            .get("enums")?
+            .as_object()?
+            .iter()
+            .map(|(name, enum_)| {
+                let members: Vec<_> = enum_
+                    .get("members")
+                    .and_then(Value::as_object)
+                    .into_iter()
+                    .flatten()
+                    .map(|(name, value)| EnumMember {
+                        name: Arc::from(name.as_str()),
+                        value: value.as_i64().unwrap_or_default(),
+                    })
+                    .collect();
+
+                Enum {
+                    name: Arc::from(name.as_str()),
+                    alignment: enum_
+                        .get("alignment")
+                        .and_then(Value::as_u64)
+                        .unwrap_or_default() as u8,
+                    size: members.len() as u16,
+                    members,
+                }
+            })
+            .collect();
+
+        Some(
+            [(module_name.to_string(), (classes, enums))]
+                .into_iter()
+                .collect(),
+        )
+    }
+
+    #[test]
+    #[ignore = "benchmark"]
+    fn format_schemas() -> Result<()> {
+        const ITERATIONS: u32 = 20;
+
+        let schemas = load_schemas("server.dll").unwrap();
+        let item = Item::Schemas(
+            SchemaModule::iter(&schemas, SchemaOptions::default())
+                .next()
+                .unwrap(),
+        );
+
+        let mut out = Vec::new();
+
+        for file_type in ["cs", "hpp", "json", "rs"] {
+            let now = Instant::now();
+
+            for _ in 0..ITERATIONS {
+                out.clear();
+
+                let mut fmt = Formatter::new(&mut out, 4);
+                let result = item.write(&mut fmt, file_type);
+
+                fmt.finish(result)?;
+            }
+
+            let elapsed = now.elapsed() / ITERATIONS;
+
+            println!(
+                "{}: {} lines ({} bytes) in {:.2?}",
+                file_type,
+                out.iter().filter(|&&b| b == b'\n').count(),
+                out.len(),
+                elapsed
+            );
+        }
+
+        Ok(())
+    }
+
+    /// Runs every writer over the result of analyzing the benchmark snapshot, see
+    /// [`Replay::open_bench`].
+    #[test]
+    #[ignore = "benchmark"]
+    fn format_snapshot() -> Result<()> {
+        const ITERATIONS: u32 = 5;
+
+        let mut replay = Replay::open_bench()?;
+
+        let result = analyze_all(&mut replay, 1, None, Filter::default(), None, None)?;
+
+        let mut items = vec![
+            Item::Buttons(&result.buttons),
+            Item::Interfaces(&result.interfaces),
+            Item::Offsets(&result.offsets),
+        ];
+
+        items.extend(
+            SchemaModule::iter(&result.schemas, SchemaOptions::default()).map(Item::Schemas),
+        );
+
+        let mut out = Vec::new();
+
+        for file_type in ["bin", "cs", "hpp", "json", "rs"] {
+            let now = Instant::now();
+
+            for _ in 0..ITERATIONS {
+                out.clear();
+
+                if file_type == "bin" {
+                    bin::write_bin(&result, &mut out)?;
+
+                    continue;
+                }
+
+                for item in &items {
+                    let mut fmt = Formatter::new(&mut out, 4);
+                    let result = item.write(&mut fmt, file_type);
+
+                    fmt.finish(result)?;
+                }
+            }
+
+            println!(
+                "{}: {} files ({} bytes) in {:.2?}",
+                file_type,
+                if file_type == "bin" { 1 } else { items.len() },
+                out.len(),
+                now.elapsed() / ITERATIONS
+            );
+        }
+
+        Ok(())
+    }
+}
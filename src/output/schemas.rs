@@ -1,32 +1,196 @@
-use std::collections::{BTreeMap, HashSet};
+use std::collections::HashSet;
 use std::fmt::{self, Write};
+use std::mem;
 
 use heck::{AsPascalCase, AsSnakeCase};
 
-use serde_json::json;
+use serde::ser::SerializeMap;
+use serde::{Deserialize, Serialize, Serializer};
 
-use super::{CodeWriter, Formatter, SchemaMap, slugify};
+use super::layout::StructLayouts;
+use super::lookup::LookupTable;
+use super::{CodeWriter, Formatter, slugify};
 
-use crate::analysis::ClassMetadata;
+use crate::analysis::{ClassView, EnumView, FieldView, MetadataView, ModuleView, SchemaMap};
 
-impl CodeWriter for SchemaMap {
+/// Settings that change the contents of the schema files.
+#[derive(Clone, Copy, Debug, Default, Deserialize, PartialEq, Eq, Serialize)]
+pub struct SchemaOptions {
+    /// Whether to include the inherited fields of every class, sorted by offset.
+    pub flatten: bool,
+
+    /// Whether to append the `repr(C)` struct of every class, with explicit padding, to the `hpp`
+    /// and `rs` files.
+    pub layouts: bool,
+
+    /// Whether to append a perfect-hash table of field offsets to the `hpp` and `rs` files.
+    pub lookup_tables: bool,
+}
+
+/// The classes and enums of a single schema module, as written to its files.
+#[derive(Clone, Copy)]
+pub struct SchemaModule<'a> {
+    pub module: ModuleView<'a>,
+    pub options: SchemaOptions,
+}
+
+impl<'a> SchemaModule<'a> {
+    pub fn iter(
+        schemas: &'a SchemaMap,
+        options: SchemaOptions,
+    ) -> impl Iterator<Item = SchemaModule<'a>> {
+        schemas
+            .modules()
+            .map(move |module| SchemaModule { module, options })
+    }
+
+    /// Returns the fields to write for a class, each together with the class that declares it.
+    pub fn fields(&self, class: ClassView<'a>) -> Vec<(ClassView<'a>, FieldView<'a>)> {
+        if self.options.flatten {
+            class.flattened_fields()
+        } else {
+            class.fields().map(|field| (class, field)).collect()
+        }
+    }
+
+    fn lookup_table(&self) -> LookupTable<'a> {
+        LookupTable::new(self.module.classes().flat_map(|class| {
+            let class_name = slugify(class.name);
+
+            self.fields(class)
+                .into_iter()
+                .map(move |(_, field)| (class_name.clone(), field.name, field.offset))
+        }))
+    }
+}
+
+impl CodeWriter for SchemaModule<'_> {
     fn write_cs(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
         fmt.block("namespace CS2Dumper.Schemas", false, |fmt| {
-            for (module_name, (classes, enums)) in self {
+            let module_name = self.module.name;
+            let (classes, enums) = (self.module.classes(), self.module.enums());
+
+            writeln!(fmt, "// Module: {}", module_name)?;
+            writeln!(fmt, "// Class count: {}", classes.len())?;
+            writeln!(fmt, "// Enum count: {}", enums.len())?;
+
+            fmt.block(
+                &format!("public static class {}", AsPascalCase(slugify(module_name))),
+                false,
+                |fmt| {
+                    for enum_ in enums {
+                        let type_name = match enum_.alignment {
+                            1 => "byte",
+                            2 => "ushort",
+                            4 => "uint",
+                            8 => "ulong",
+                            _ => continue,
+                        };
+
+                        writeln!(fmt, "// Alignment: {}", enum_.alignment)?;
+                        writeln!(fmt, "// Member count: {}", enum_.size)?;
+
+                        fmt.block(
+                            &format!("public enum {} : {}", slugify(&enum_.name), type_name),
+                            false,
+                            |fmt| {
+                                let members = enum_
+                                    .members()
+                                    .map(|member| {
+                                        let hex = if member.value < 0
+                                            || member.value > i32::MAX as i64
+                                        {
+                                            format!("unchecked(({}){})", type_name, member.value)
+                                        } else {
+                                            format!("{:#X}", member.value)
+                                        };
+                                        format!("{} = {}", member.name, hex)
+                                    })
+                                    .collect::<Vec<_>>()
+                                    .join(",\n");
+
+                                writeln!(fmt, "{}", members)
+                            },
+                        )?;
+                    }
+
+                    for class in classes {
+                        let parent_name = class
+                            .parent
+                            .map(slugify)
+                            .unwrap_or_else(|| String::from("None"));
+
+                        let fields = self.fields(class);
+
+                        writeln!(fmt, "// Parent: {}", parent_name)?;
+                        writeln!(fmt, "// Field count: {}", fields.len())?;
+
+                        write_metadata(fmt, class.metadata())?;
+
+                        fmt.block(
+                            &format!("public static class {}", slugify(&class.name)),
+                            false,
+                            |fmt| {
+                                for &(owner, field) in &fields {
+                                    writeln!(
+                                        fmt,
+                                        "public const nint {} = {:#X}; // {}{}",
+                                        field.name,
+                                        field.offset,
+                                        field.type_name,
+                                        InheritedFrom(class, owner)
+                                    )?;
+                                }
+
+                                Ok(())
+                            },
+                        )?;
+                    }
+
+                    Ok(())
+                },
+            )?;
+
+            Ok(())
+        })
+    }
+
+    fn write_hpp(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
+        writeln!(fmt, "#pragma once\n")?;
+
+        writeln!(fmt, "#include <cstddef>")?;
+
+        if self.options.layouts || self.options.lookup_tables {
+            writeln!(fmt, "#include <cstdint>")?;
+        }
+
+        if self.options.lookup_tables {
+            writeln!(fmt, "#include <iterator>")?;
+            writeln!(fmt, "#include <optional>")?;
+            writeln!(fmt, "#include <string_view>")?;
+        }
+
+        writeln!(fmt)?;
+
+        fmt.block("namespace cs2_dumper", false, |fmt| {
+            fmt.block("namespace schemas", false, |fmt| {
+                let module_name = self.module.name;
+                let (classes, enums) = (self.module.classes(), self.module.enums());
+
                 writeln!(fmt, "// Module: {}", module_name)?;
                 writeln!(fmt, "// Class count: {}", classes.len())?;
                 writeln!(fmt, "// Enum count: {}", enums.len())?;
 
                 fmt.block(
-                    &format!("public static class {}", AsPascalCase(slugify(module_name))),
+                    &format!("namespace {}", AsSnakeCase(slugify(module_name))),
                     false,
                     |fmt| {
                         for enum_ in enums {
                             let type_name = match enum_.alignment {
-                                1 => "byte",
-                                2 => "ushort",
-                                4 => "uint",
-                                8 => "ulong",
+                                1 => "uint8_t",
+                                2 => "uint16_t",
+                                4 => "uint32_t",
+                                8 => "uint64_t",
                                 _ => continue,
                             };
 
@@ -34,24 +198,13 @@ impl CodeWriter for SchemaMap {
                             writeln!(fmt, "// Member count: {}", enum_.size)?;
 
                             fmt.block(
-                                &format!("public enum {} : {}", slugify(&enum_.name), type_name),
-                                false,
+                                &format!("enum class {} : {}", slugify(&enum_.name), type_name),
+                                true,
                                 |fmt| {
                                     let members = enum_
-                                        .members
-                                        .iter()
+                                        .members()
                                         .map(|member| {
-                                            let hex = if member.value < 0
-                                                || member.value > i32::MAX as i64
-                                            {
-                                                format!(
-                                                    "unchecked(({}){})",
-                                                    type_name, member.value
-                                                )
-                                            } else {
-                                                format!("{:#X}", member.value)
-                                            };
-                                            format!("{} = {}", member.name, hex)
+                                            format!("{} = {:#X}", member.name, member.value)
                                         })
                                         .collect::<Vec<_>>()
                                         .join(",\n");
@@ -64,24 +217,28 @@ impl CodeWriter for SchemaMap {
                         for class in classes {
                             let parent_name = class
                                 .parent
-                                .as_ref()
-                                .map(|parent| slugify(&parent.name))
+                                .map(slugify)
                                 .unwrap_or_else(|| String::from("None"));
 
+                            let fields = self.fields(class);
+
                             writeln!(fmt, "// Parent: {}", parent_name)?;
-                            writeln!(fmt, "// Field count: {}", class.fields.len())?;
+                            writeln!(fmt, "// Field count: {}", fields.len())?;
 
-                            write_metadata(fmt, &class.metadata)?;
+                            write_metadata(fmt, class.metadata())?;
 
                             fmt.block(
-                                &format!("public static class {}", slugify(&class.name)),
+                                &format!("namespace {}", slugify(&class.name)),
                                 false,
                                 |fmt| {
-                                    for field in &class.fields {
+                                    for &(owner, field) in &fields {
                                         writeln!(
                                             fmt,
-                                            "public const nint {} = {:#X}; // {}",
-                                            field.name, field.offset, field.type_name
+                                            "constexpr std::ptrdiff_t {} = {:#X}; // {}{}",
+                                            field.name,
+                                            field.offset,
+                                            field.type_name,
+                                            InheritedFrom(class, owner)
                                         )?;
                                     }
 
@@ -90,93 +247,25 @@ impl CodeWriter for SchemaMap {
                             )?;
                         }
 
-                        Ok(())
-                    },
-                )?;
-            }
-
-            Ok(())
-        })
-    }
-
-    fn write_hpp(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
-        writeln!(fmt, "#pragma once\n")?;
-        writeln!(fmt, "#include <cstddef>\n")?;
+                        if self.options.layouts {
+                            let layouts = StructLayouts::new(self.module);
 
-        fmt.block("namespace cs2_dumper", false, |fmt| {
-            fmt.block("namespace schemas", false, |fmt| {
-                for (module_name, (classes, enums)) in self {
-                    writeln!(fmt, "// Module: {}", module_name)?;
-                    writeln!(fmt, "// Class count: {}", classes.len())?;
-                    writeln!(fmt, "// Enum count: {}", enums.len())?;
-
-                    fmt.block(
-                        &format!("namespace {}", AsSnakeCase(slugify(module_name))),
-                        false,
-                        |fmt| {
-                            for enum_ in enums {
-                                let type_name = match enum_.alignment {
-                                    1 => "uint8_t",
-                                    2 => "uint16_t",
-                                    4 => "uint32_t",
-                                    8 => "uint64_t",
-                                    _ => continue,
-                                };
-
-                                writeln!(fmt, "// Alignment: {}", enum_.alignment)?;
-                                writeln!(fmt, "// Member count: {}", enum_.size)?;
-
-                                fmt.block(
-                                    &format!("enum class {} : {}", slugify(&enum_.name), type_name),
-                                    true,
-                                    |fmt| {
-                                        let members = enum_
-                                            .members
-                                            .iter()
-                                            .map(|member| {
-                                                format!("{} = {:#X}", member.name, member.value)
-                                            })
-                                            .collect::<Vec<_>>()
-                                            .join(",\n");
-
-                                        writeln!(fmt, "{}", members)
-                                    },
-                                )?;
+                            if !layouts.is_empty() {
+                                layouts.write_hpp(fmt)?;
                             }
+                        }
 
-                            for class in classes {
-                                let parent_name = class
-                                    .parent
-                                    .as_ref()
-                                    .map(|parent| slugify(&parent.name))
-                                    .unwrap_or_else(|| String::from("None"));
-
-                                writeln!(fmt, "// Parent: {}", parent_name)?;
-                                writeln!(fmt, "// Field count: {}", class.fields.len())?;
-
-                                write_metadata(fmt, &class.metadata)?;
-
-                                fmt.block(
-                                    &format!("namespace {}", slugify(&class.name)),
-                                    false,
-                                    |fmt| {
-                                        for field in &class.fields {
-                                            writeln!(
-                                                fmt,
-                                                "constexpr std::ptrdiff_t {} = {:#X}; // {}",
-                                                field.name, field.offset, field.type_name
-                                            )?;
-                                        }
-
-                                        Ok(())
-                                    },
-                                )?;
+                        if self.options.lookup_tables {
+                            let table = self.lookup_table();
+
+                            if !table.is_empty() {
+                                table.write_hpp(fmt)?;
                             }
+                        }
 
-                            Ok(())
-                        },
-                    )?;
-                }
+                        Ok(())
+                    },
+                )?;
 
                 Ok(())
             })
@@ -184,88 +273,9 @@ impl CodeWriter for SchemaMap {
     }
 
     fn write_json(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
-        let content: BTreeMap<_, _> = self
-            .iter()
-            .map(|(module_name, (classes, enums))| {
-                let classes: BTreeMap<_, _> = classes
-                    .iter()
-                    .map(|class| {
-                        let fields: BTreeMap<_, _> = class
-                            .fields
-                            .iter()
-                            .map(|field| (&field.name, field.offset))
-                            .collect();
-
-                        let metadata: Vec<_> = class
-                            .metadata
-                            .iter()
-                            .map(|metadata| match metadata {
-                                ClassMetadata::NetworkChangeCallback { name } => json!({
-                                    "type": "NetworkChangeCallback",
-                                    "name": name,
-                                }),
-                                ClassMetadata::NetworkVarNames { name, type_name } => json!({
-                                    "type": "NetworkVarNames",
-                                    "name": name,
-                                    "type_name": type_name,
-                                }),
-                                ClassMetadata::Unknown { name } => json!({
-                                    "type": "Unknown",
-                                    "name": name,
-                                }),
-                            })
-                            .collect();
-
-                        (
-                            slugify(&class.name),
-                            json!({
-                                "parent": class.parent.as_ref().map(|parent| &parent.name),
-                                "fields": fields,
-                                "metadata": metadata
-                            }),
-                        )
-                    })
-                    .collect();
-
-                let enums: BTreeMap<_, _> = enums
-                    .iter()
-                    .map(|enum_| {
-                        let members: BTreeMap<_, _> = enum_
-                            .members
-                            .iter()
-                            .map(|member| (&member.name, member.value))
-                            .collect();
-
-                        let type_name = match enum_.alignment {
-                            1 => "uint8",
-                            2 => "uint16",
-                            4 => "uint32",
-                            8 => "uint64",
-                            _ => "unknown",
-                        };
+        let content = JsonMap(|| [(self.module.name, JsonModule(*self))]);
 
-                        (
-                            slugify(&enum_.name),
-                            json!({
-                                "alignment": enum_.alignment,
-                                "type": type_name,
-                                "members": members,
-                            }),
-                        )
-                    })
-                    .collect();
-
-                (
-                    module_name,
-                    json!({
-                        "classes": classes,
-                        "enums": enums,
-                    }),
-                )
-            })
-            .collect();
-
-        fmt.write_str(&serde_json::to_string_pretty(&content).unwrap())
+        fmt.serialize_json(&content)
     }
 
     fn write_rs(&self, fmt: &mut Formatter<'_>) -> fmt::Result {
@@ -276,95 +286,115 @@ impl CodeWriter for SchemaMap {
 
         fmt.block("pub mod cs2_dumper", false, |fmt| {
             fmt.block("pub mod schemas", false, |fmt| {
-                for (module_name, (classes, enums)) in self {
-                    writeln!(fmt, "// Module: {}", module_name)?;
-                    writeln!(fmt, "// Class count: {}", classes.len())?;
-                    writeln!(fmt, "// Enum count: {}", enums.len())?;
-
-                    fmt.block(
-                        &format!("pub mod {}", AsSnakeCase(slugify(module_name))),
-                        false,
-                        |fmt| {
-                            for enum_ in enums {
-                                let type_name = match enum_.alignment {
-                                    1 => "u8",
-                                    2 => "u16",
-                                    4 => "u32",
-                                    8 => "u64",
-                                    _ => continue,
-                                };
-
-                                writeln!(fmt, "// Alignment: {}", enum_.alignment)?;
-                                writeln!(fmt, "// Member count: {}", enum_.size)?;
-
-                                fmt.block(
-                                    &format!(
-                                        "#[repr({})]\npub enum {}",
-                                        type_name,
-                                        slugify(&enum_.name),
-                                    ),
-                                    false,
-                                    |fmt| {
-                                        let mut used_values = HashSet::new();
-
-                                        let members = enum_
-                                            .members
-                                            .iter()
-                                            .filter_map(|member| {
-                                                // Filter out duplicate values.
-                                                if used_values.insert(member.value) {
-                                                    let value = if member.value == -1 {
-                                                        format!("{}::MAX", type_name)
-                                                    } else {
-                                                        format!("{:#X}", member.value)
-                                                    };
-
-                                                    Some(format!("{} = {}", member.name, value))
+                let module_name = self.module.name;
+                let (classes, enums) = (self.module.classes(), self.module.enums());
+
+                writeln!(fmt, "// Module: {}", module_name)?;
+                writeln!(fmt, "// Class count: {}", classes.len())?;
+                writeln!(fmt, "// Enum count: {}", enums.len())?;
+
+                fmt.block(
+                    &format!("pub mod {}", AsSnakeCase(slugify(module_name))),
+                    false,
+                    |fmt| {
+                        for enum_ in enums {
+                            let type_name = match enum_.alignment {
+                                1 => "u8",
+                                2 => "u16",
+                                4 => "u32",
+                                8 => "u64",
+                                _ => continue,
+                            };
+
+                            writeln!(fmt, "// Alignment: {}", enum_.alignment)?;
+                            writeln!(fmt, "// Member count: {}", enum_.size)?;
+
+                            fmt.block(
+                                &format!(
+                                    "#[repr({})]\npub enum {}",
+                                    type_name,
+                                    slugify(&enum_.name),
+                                ),
+                                false,
+                                |fmt| {
+                                    let mut used_values = HashSet::new();
+
+                                    let members = enum_
+                                        .members()
+                                        .filter_map(|member| {
+                                            // Filter out duplicate values.
+                                            if used_values.insert(member.value) {
+                                                let value = if member.value == -1 {
+                                                    format!("{}::MAX", type_name)
                                                 } else {
-                                                    None
-                                                }
-                                            })
-                                            .collect::<Vec<_>>()
-                                            .join(",\n");
-
-                                        writeln!(fmt, "{}", members)
-                                    },
-                                )?;
+                                                    format!("{:#X}", member.value)
+                                                };
+
+                                                Some(format!("{} = {}", member.name, value))
+                                            } else {
+                                                None
+                                            }
+                                        })
+                                        .collect::<Vec<_>>()
+                                        .join(",\n");
+
+                                    writeln!(fmt, "{}", members)
+                                },
+                            )?;
+                        }
+
+                        for class in classes {
+                            let parent_name = class
+                                .parent
+                                .map(slugify)
+                                .unwrap_or_else(|| String::from("None"));
+
+                            let fields = self.fields(class);
+
+                            writeln!(fmt, "// Parent: {}", parent_name)?;
+                            writeln!(fmt, "// Field count: {}", fields.len())?;
+
+                            write_metadata(fmt, class.metadata())?;
+
+                            fmt.block(
+                                &format!("pub mod {}", slugify(&class.name)),
+                                false,
+                                |fmt| {
+                                    for &(owner, field) in &fields {
+                                        writeln!(
+                                            fmt,
+                                            "pub const {}: usize = {:#X}; // {}{}",
+                                            field.name,
+                                            field.offset,
+                                            field.type_name,
+                                            InheritedFrom(class, owner)
+                                        )?;
+                                    }
+
+                                    Ok(())
+                                },
+                            )?;
+                        }
+
+                        if self.options.layouts {
+                            let layouts = StructLayouts::new(self.module);
+
+                            if !layouts.is_empty() {
+                                layouts.write_rs(fmt)?;
                             }
+                        }
+
+                        if self.options.lookup_tables {
+                            let table = self.lookup_table();
 
-                            for class in classes {
-                                let parent_name = class
-                                    .parent
-                                    .as_ref()
-                                    .map(|parent| slugify(&parent.name))
-                                    .unwrap_or_else(|| String::from("None"));
-
-                                writeln!(fmt, "// Parent: {}", parent_name)?;
-                                writeln!(fmt, "// Field count: {}", class.fields.len())?;
-
-                                write_metadata(fmt, &class.metadata)?;
-
-                                fmt.block(
-                                    &format!("pub mod {}", slugify(&class.name)),
-                                    false,
-                                    |fmt| {
-                                        for field in &class.fields {
-                                            writeln!(
-                                                fmt,
-                                                "pub const {}: usize = {:#X}; // {}",
-                                                field.name, field.offset, field.type_name
-                                            )?;
-                                        }
-
-                                        Ok(())
-                                    },
-                                )?;
+                            if !table.is_empty() {
+                                table.write_rs(fmt)?;
                             }
+                        }
 
-                            Ok(())
-                        },
-                    )?;
-                }
+                        Ok(())
+                    },
+                )?;
 
                 Ok(())
             })
@@ -372,8 +402,180 @@ impl CodeWriter for SchemaMap {
     }
 }
 
-fn write_metadata(fmt: &mut Formatter<'_>, metadata: &[ClassMetadata]) -> fmt::Result {
-    if metadata.is_empty() {
+/// Names the class that declares a field in the comment after it, if it isn't the class the field
+/// is written for.
+struct InheritedFrom<'a>(ClassView<'a>, ClassView<'a>);
+
+impl fmt::Display for InheritedFrom<'_> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let InheritedFrom(class, owner) = self;
+
+        if class == owner {
+            return Ok(());
+        }
+
+        write!(f, " (inherited from {})", slugify(owner.name))
+    }
+}
+
+/// Serializes the entries returned by a closure as a JSON object, without collecting them first.
+struct JsonMap<F>(F);
+
+impl<F, I, K, V> Serialize for JsonMap<F>
+where
+    F: Fn() -> I,
+    I: IntoIterator<Item = (K, V)>,
+    K: Serialize,
+    V: Serialize,
+{
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        serializer.collect_map((self.0)())
+    }
+}
+
+/// The `json` file layout of a module, serialized straight from the schema map.
+///
+/// The objects are written with sorted keys, and of repeated keys only the last entry is kept, as
+/// if they had been collected into a `BTreeMap` first. Only the sorted keys of a single level are
+/// held in memory at a time.
+struct JsonModule<'a>(SchemaModule<'a>);
+
+impl Serialize for JsonModule<'_> {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        let module = self.0;
+
+        let classes = sorted_entries(
+            module
+                .module
+                .classes()
+                .map(|class| (slugify(class.name), class)),
+        );
+
+        let enums = sorted_entries(
+            module
+                .module
+                .enums()
+                .map(|enum_| (slugify(enum_.name), enum_)),
+        );
+
+        let mut map = serializer.serialize_map(Some(2))?;
+
+        map.serialize_entry(
+            "classes",
+            &JsonMap(|| {
+                classes
+                    .iter()
+                    .map(|(name, class)| (name, JsonClass(module, *class)))
+            }),
+        )?;
+
+        map.serialize_entry(
+            "enums",
+            &JsonMap(|| enums.iter().map(|(name, enum_)| (name, JsonEnum(*enum_)))),
+        )?;
+
+        map.end()
+    }
+}
+
+struct JsonClass<'a>(SchemaModule<'a>, ClassView<'a>);
+
+impl Serialize for JsonClass<'_> {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        let JsonClass(module, class) = *self;
+
+        let fields = sorted_entries(
+            module
+                .fields(class)
+                .into_iter()
+                .map(|(_, field)| (field.name, field.offset)),
+        );
+
+        let mut map = serializer.serialize_map(Some(3))?;
+
+        map.serialize_entry("fields", &JsonMap(|| fields.iter().copied()))?;
+        map.serialize_entry("metadata", &JsonMetadata(class))?;
+        map.serialize_entry("parent", &class.parent)?;
+
+        map.end()
+    }
+}
+
+struct JsonMetadata<'a>(ClassView<'a>);
+
+impl Serialize for JsonMetadata<'_> {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        serializer.collect_seq(self.0.metadata().map(|metadata| {
+            let (type_name, name, metadata_type_name) = match metadata {
+                MetadataView::NetworkChangeCallback { name } => {
+                    ("NetworkChangeCallback", name, None)
+                }
+                MetadataView::NetworkVarNames { name, type_name } => {
+                    ("NetworkVarNames", name, Some(type_name))
+                }
+                MetadataView::Unknown { name } => ("Unknown", name, None),
+            };
+
+            JsonMap(move || {
+                [("name", name), ("type", type_name)]
+                    .into_iter()
+                    .chain(metadata_type_name.map(|type_name| ("type_name", type_name)))
+            })
+        }))
+    }
+}
+
+struct JsonEnum<'a>(EnumView<'a>);
+
+impl Serialize for JsonEnum<'_> {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        let enum_ = self.0;
+
+        let members = sorted_entries(enum_.members().map(|member| (member.name, member.value)));
+
+        let type_name = match enum_.alignment {
+            1 => "uint8",
+            2 => "uint16",
+            4 => "uint32",
+            8 => "uint64",
+            _ => "unknown",
+        };
+
+        let mut map = serializer.serialize_map(Some(3))?;
+
+        map.serialize_entry("alignment", &enum_.alignment)?;
+        map.serialize_entry("members", &JsonMap(|| members.iter().copied()))?;
+        map.serialize_entry("type", type_name)?;
+
+        map.end()
+    }
+}
+
+/// Sorts entries by key, keeping only the last of any repeated key.
+fn sorted_entries<K: Ord, V>(entries: impl Iterator<Item = (K, V)>) -> Vec<(K, V)> {
+    let mut entries: Vec<_> = entries.collect();
+
+    entries.sort_by(|(a, _), (b, _)| a.cmp(b));
+
+    // The sort is stable, so the last of a run of equal keys is the one that came last.
+    entries.dedup_by(|next, prev| {
+        let same = next.0 == prev.0;
+
+        if same {
+            mem::swap(next, prev);
+        }
+
+        same
+    });
+
+    entries
+}
+
+fn write_metadata<'a>(
+    fmt: &mut Formatter<'_>,
+    metadata: impl ExactSizeIterator<Item = MetadataView<'a>>,
+) -> fmt::Result {
+    if metadata.len() == 0 {
         return Ok(());
     }
 
@@ -382,13 +584,13 @@ fn write_metadata(fmt: &mut Formatter<'_>, metadata: &[ClassMetadata]) -> fmt::R
 
     for metadata in metadata {
         match metadata {
-            ClassMetadata::NetworkChangeCallback { name } => {
+            MetadataView::NetworkChangeCallback { name } => {
                 writeln!(fmt, "// NetworkChangeCallback: {}", name)?;
             }
-            ClassMetadata::NetworkVarNames { name, type_name } => {
+            MetadataView::NetworkVarNames { name, type_name } => {
                 writeln!(fmt, "// NetworkVarNames: {} ({})", name, type_name)?;
             }
-            ClassMetadata::Unknown { name } => {
+            MetadataView::Unknown { name } => {
                 writeln!(fmt, "// {}", name)?;
             }
         }
@@ -396,3 +598,92 @@ fn write_metadata(fmt: &mut Formatter<'_>, metadata: &[ClassMetadata]) -> fmt::R
 
     Ok(())
 }
+
+#[cfg(test)]
+mod tests {
+    use std::sync::Arc;
+
+    use serde_json::json;
+
+    use crate::analysis::{Class, ClassMetadata, Enum, EnumMember};
+
+    use super::*;
+
+    #[test]
+    fn json_matches_sorted_maps() {
+        let member = |name: &str, value| EnumMember {
+            name: Arc::from(name),
+            value,
+        };
+
+        let classes = vec![
+            Class::new("client.dll", "C_Foo")
+                .with_metadata(vec![
+                    ClassMetadata::NetworkVarNames {
+                        name: Arc::from("m_a"),
+                        type_name: Arc::from("int32"),
+                    },
+                    ClassMetadata::Unknown {
+                        name: Arc::from("MNetworkEnable"),
+                    },
+                ])
+                .with_fields([
+                    ("m_b", "int32", 0x8),
+                    ("m_a", "int32", 0x10),
+                    ("m_a", "int32", 0x14),
+                ]),
+            Class::new("client.dll", "C::Bar"),
+        ];
+
+        let enums = vec![Enum {
+            name: Arc::from("EFoo"),
+            alignment: 4,
+            size: 3,
+            members: vec![member("B", 1), member("A", 2), member("B", 3)],
+        }];
+
+        let schemas: SchemaMap = [("client.dll".to_string(), (classes, enums))]
+            .into_iter()
+            .collect();
+
+        let module = SchemaModule::iter(&schemas, SchemaOptions::default())
+            .next()
+            .unwrap();
+
+        let mut out = Vec::new();
+
+        let mut fmt = Formatter::new(&mut out, 4);
+        let result = module.write_json(&mut fmt);
+
+        fmt.finish(result).unwrap();
+
+        // Repeated keys keep their last value, like they did when collected into a map.
+        let expected = json!({
+            "client.dll": {
+                "classes": {
+                    "C_Foo": {
+                        "fields": { "m_a": 0x14, "m_b": 0x8 },
+                        "metadata": [
+                            { "type": "NetworkVarNames", "name": "m_a", "type_name": "int32" },
+                            { "type": "Unknown", "name": "MNetworkEnable" },
+                        ],
+                        "parent": null,
+                    },
+                    "C__Bar": { "fields": {}, "metadata": [], "parent": null },
+                },
+                "enums": {
+                    "EFoo": {
+                        "alignment": 4,
+                        "type": "uint32",
+                        "members": { "A": 2, "B": 3 },
+                    },
+                },
+            },
+        });
+
+        assert_eq!(
+            String::from_utf8(out).unwrap(),
+            serde_json::to_string_pretty(&expected).unwrap()
+        );
+    }
+}
@@ -0,0 +1,475 @@
+use std::collections::{BTreeMap, BTreeSet, HashMap};
+use std::io::{self, BufRead, BufReader, Read, Write};
+use std::net::{TcpListener, TcpStream};
+use std::path::Path;
+use std::sync::{Arc, Mutex};
+use std::thread;
+
+use anyhow::Result;
+
+use log::{debug, info, warn};
+
+use serde_json::json;
+
+use crate::analysis::AnalysisResult;
+use crate::output;
+
+/// The longest request line or header that is accepted.
+const MAX_LINE_LEN: u64 = 8192;
+
+/// Answers lookups of single values of the latest dump over HTTP, for the `--serve` option.
+///
+/// Every path names a value the way the `json` files do, e.g. `/offsets/client.dll/dwEntityList`
+/// or `/schemas/client.dll/C_BaseEntity/m_iHealth`, and `/schemas/MODULE/CLASS` returns all
+/// fields of a class. Responses carry an `ETag` of the whole dump and its build number, so that
+/// clients can revalidate with `If-None-Match` instead of fetching again.
+pub struct Server {
+    index: Arc<Mutex<Option<Arc<Index>>>>,
+}
+
+/// The values of a dump in hash maps, keyed like the `json` files.
+#[derive(Debug, Default)]
+struct Index {
+    build_number: Option<u32>,
+
+    /// An order-independent hash of every value, quoted for the `ETag` header.
+    etag: String,
+
+    buttons: HashMap<String, i64>,
+    interfaces: HashMap<String, HashMap<String, u64>>,
+    offsets: HashMap<String, HashMap<String, u64>>,
+
+    /// The field offsets of every class of every module.
+    schemas: HashMap<String, HashMap<String, HashMap<String, i64>>>,
+}
+
+struct Response {
+    status: &'static str,
+    body: String,
+}
+
+impl Server {
+    /// Starts accepting connections on `addr`, each of them on its own thread. Lookups fail with
+    /// `503` until the first dump is published.
+    pub fn start(addr: &str) -> Result<Self> {
+        let listener = TcpListener::bind(addr)?;
+
+        info!("serving lookups on http://{}", listener.local_addr()?);
+
+        let index = Arc::new(Mutex::new(None));
+        let shared = index.clone();
+
+        thread::spawn(move || {
+            for stream in listener.incoming() {
+                let stream = match stream {
+                    Ok(stream) => stream,
+                    Err(err) => {
+                        warn!("failed to accept connection: {}", err);
+
+                        continue;
+                    }
+                };
+
+                let index = shared.clone();
+
+                thread::spawn(move || {
+                    if let Err(err) = handle_connection(stream, &index) {
+                        debug!("connection closed: {}", err);
+                    }
+                });
+            }
+        });
+
+        Ok(Self { index })
+    }
+
+    /// Replaces the served dump. Requests that are being answered keep using the previous one.
+    ///
+    /// The schemas of the type scopes in `reused` weren't read again, so they are carried over
+    /// from the previous dump, or read from their `json` files in `out_dir` if there is none.
+    pub fn publish(
+        &self,
+        result: &AnalysisResult,
+        build_number: Option<u32>,
+        reused: &BTreeSet<String>,
+        out_dir: &Path,
+        flatten: bool,
+    ) {
+        let prev = self.index.lock().unwrap().clone();
+
+        let mut index = Index::new(result, build_number, flatten);
+
+        for module_name in reused {
+            let classes = match prev.as_ref().and_then(|prev| prev.schemas.get(module_name)) {
+                Some(classes) => classes.clone(),
+                None => output::read_schema_fields(out_dir, module_name)
+                    .unwrap_or_default()
+                    .into_iter()
+                    .map(|(class_name, fields)| (class_name, fields.into_iter().collect()))
+                    .collect(),
+            };
+
+            index.schemas.insert(module_name.clone(), classes);
+        }
+
+        index.etag = format!("\"{:016x}\"", index.content_hash());
+
+        info!("serving dump {}", index.etag);
+
+        *self.index.lock().unwrap() = Some(Arc::new(index));
+    }
+}
+
+impl Index {
+    fn new(result: &AnalysisResult, build_number: Option<u32>, flatten: bool) -> Self {
+        let buttons = result
+            .buttons
+            .iter()
+            .map(|(name, value)| (name.clone(), *value as i64))
+            .collect();
+
+        let interfaces = result
+            .interfaces
+            .iter()
+            .map(|(module_name, ifaces)| {
+                let ifaces = ifaces
+                    .iter()
+                    .map(|(name, value)| (name.clone(), *value as u64))
+                    .collect();
+
+                (module_name.clone(), ifaces)
+            })
+            .collect();
+
+        let offsets = result
+            .offsets
+            .iter()
+            .map(|(module_name, offsets)| {
+                let offsets = offsets
+                    .iter()
+                    .map(|(name, value)| (name.clone(), *value as u64))
+                    .collect();
+
+                (module_name.clone(), offsets)
+            })
+            .collect();
+
+        let schemas = result
+            .schemas
+            .modules()
+            .map(|module| {
+                // Built like the `json` file, where the last of any repeated name wins.
+                let classes = module
+                    .classes()
+                    .map(|class| {
+                        let fields: Vec<_> = if flatten {
+                            class
+                                .flattened_fields()
+                                .into_iter()
+                                .map(|(_, f)| f)
+                                .collect()
+                        } else {
+                            class.fields().collect()
+                        };
+
+                        let fields = fields
+                            .into_iter()
+                            .map(|field| (field.name.to_string(), field.offset as i64))
+                            .collect();
+
+                        (output::slugify(class.name), fields)
+                    })
+                    .collect();
+
+                (module.name.to_string(), classes)
+            })
+            .collect();
+
+        Self {
+            build_number,
+            etag: String::new(),
+            buttons,
+            interfaces,
+            offsets,
+            schemas,
+        }
+    }
+
+    /// Sums the hashes of all values, so that the order of the hash maps doesn't matter.
+    fn content_hash(&self) -> u64 {
+        let mut sum = entry_hash(&[b"build", &self.build_number.unwrap_or(0).to_le_bytes()]);
+
+        for (name, value) in &self.buttons {
+            sum = sum.wrapping_add(entry_hash(&[
+                b"buttons",
+                name.as_bytes(),
+                &value.to_le_bytes(),
+            ]));
+        }
+
+        for (kind, modules) in [("interfaces", &self.interfaces), ("offsets", &self.offsets)] {
+            for (module_name, values) in modules {
+                for (name, value) in values {
+                    sum = sum.wrapping_add(entry_hash(&[
+                        kind.as_bytes(),
+                        module_name.as_bytes(),
+                        name.as_bytes(),
+                        &value.to_le_bytes(),
+                    ]));
+                }
+            }
+        }
+
+        for (module_name, classes) in &self.schemas {
+            for (class_name, fields) in classes {
+                // Classes without fields still count.
+                sum =
+                    sum.wrapping_add(entry_hash(&[module_name.as_bytes(), class_name.as_bytes()]));
+
+                for (name, offset) in fields {
+                    sum = sum.wrapping_add(entry_hash(&[
+                        module_name.as_bytes(),
+                        class_name.as_bytes(),
+                        name.as_bytes(),
+                        &offset.to_le_bytes(),
+                    ]));
+                }
+            }
+        }
+
+        sum
+    }
+
+    /// Returns the JSON value at a path, if there is one.
+    fn lookup(&self, path: &str) -> Option<String> {
+        let path = path.split('?').next().unwrap_or_default();
+        let segments: Vec<_> = path.trim_matches('/').split('/').collect();
+
+        let value = match segments[..] {
+            [""] => json!({ "build_number": self.build_number }),
+            ["buttons", name] => json!(self.buttons.get(name)?),
+            ["interfaces", module_name, name] => {
+                json!(self.interfaces.get(module_name)?.get(name)?)
+            }
+            ["offsets", module_name, name] => json!(self.offsets.get(module_name)?.get(name)?),
+            ["schemas", module_name, class_name] => {
+                let fields: BTreeMap<_, _> = self
+                    .schemas
+                    .get(module_name)?
+                    .get(class_name)?
+                    .iter()
+                    .collect();
+
+                json!(fields)
+            }
+            ["schemas", module_name, class_name, name] => {
+                json!(self.schemas.get(module_name)?.get(class_name)?.get(name)?)
+            }
+            _ => return None,
+        };
+
+        Some(value.to_string())
+    }
+}
+
+/// Answers the requests of a connection until the client closes it or asks to.
+fn handle_connection(stream: TcpStream, index: &Mutex<Option<Arc<Index>>>) -> io::Result<()> {
+    stream.set_nodelay(true)?;
+
+    let mut reader = BufReader::new(stream.try_clone()?);
+    let mut writer = stream;
+
+    loop {
+        let Some(request_line) = read_line(&mut reader)? else {
+            return Ok(());
+        };
+
+        let mut parts = request_line.split_whitespace();
+
+        let method = parts.next().unwrap_or_default().to_string();
+        let path = parts.next().unwrap_or_default().to_string();
+
+        // HTTP/1.0 closes the connection after every request by default.
+        let mut close = parts.next() == Some("HTTP/1.0");
+        let mut if_none_match = None;
+
+        loop {
+            let Some(line) = read_line(&mut reader)? else {
+                return Ok(());
+            };
+
+            if line.is_empty() {
+                break;
+            }
+
+            let Some((name, value)) = line.split_once(':') else {
+                continue;
+            };
+
+            let value = value.trim();
+
+            if name.eq_ignore_ascii_case("connection") {
+                close = value.eq_ignore_ascii_case("close");
+            } else if name.eq_ignore_ascii_case("if-none-match") {
+                if_none_match = Some(value.to_string());
+            }
+        }
+
+        let index = index.lock().unwrap().clone();
+
+        let response = if method != "GET" && method != "HEAD" {
+            Response {
+                status: "405 Method Not Allowed",
+                body: String::new(),
+            }
+        } else {
+            match &index {
+                None => Response {
+                    status: "503 Service Unavailable",
+                    body: "no dump yet".to_string(),
+                },
+                Some(index) if if_none_match.as_deref() == Some(index.etag.as_str()) => Response {
+                    status: "304 Not Modified",
+                    body: String::new(),
+                },
+                Some(index) => match index.lookup(&path) {
+                    Some(body) => Response {
+                        status: "200 OK",
+                        body,
+                    },
+                    None => Response {
+                        status: "404 Not Found",
+                        body: "not found".to_string(),
+                    },
+                },
+            }
+        };
+
+        let mut head = format!(
+            "HTTP/1.1 {}\r\nContent-Type: application/json\r\nContent-Length: {}\r\nCache-Control: no-cache\r\n",
+            response.status,
+            response.body.len()
+        );
+
+        if let Some(index) = &index {
+            head.push_str(&format!("ETag: {}\r\n", index.etag));
+
+            if let Some(build_number) = index.build_number {
+                head.push_str(&format!("X-Build-Number: {}\r\n", build_number));
+            }
+        }
+
+        if close {
+            head.push_str("Connection: close\r\n");
+        }
+
+        head.push_str("\r\n");
+
+        if method != "HEAD" {
+            head.push_str(&response.body);
+        }
+
+        writer.write_all(head.as_bytes())?;
+
+        if close {
+            return Ok(());
+        }
+    }
+}
+
+/// Reads a line without its line ending, or `None` once the client closed the connection.
+fn read_line(reader: &mut impl BufRead) -> io::Result<Option<String>> {
+    let mut line = String::new();
+
+    let n = reader.take(MAX_LINE_LEN).read_line(&mut line)?;
+
+    if n == 0 {
+        return Ok(None);
+    }
+
+    if !line.ends_with('\n') {
+        return Err(io::Error::new(io::ErrorKind::InvalidData, "line too long"));
+    }
+
+    Ok(Some(line.trim_end().to_string()))
+}
+
+/// FNV-1a over the given parts, each followed by a separator.
+fn entry_hash(parts: &[&[u8]]) -> u64 {
+    let mut hash = 0xcbf29ce484222325u64;
+
+    for part in parts {
+        for &b in part.iter().chain(&[0xff]) {
+            hash = (hash ^ b as u64).wrapping_mul(0x100000001b3);
+        }
+    }
+
+    hash
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn lookup() {
+        let mut index = Index {
+            build_number: Some(14090),
+            ..Default::default()
+        };
+
+        index.offsets.insert(
+            "client.dll".to_string(),
+            HashMap::from([("dwEntityList".to_string(), 0x1D13CE8)]),
+        );
+
+        index.schemas.insert(
+            "client.dll".to_string(),
+            HashMap::from([(
+                "C_BaseEntity".to_string(),
+                HashMap::from([
+                    ("m_iHealth".to_string(), 0x344),
+                    ("m_iTeamNum".to_string(), 0x3E3),
+                ]),
+            )]),
+        );
+
+        assert_eq!(
+            index.lookup("/").as_deref(),
+            Some(r#"{"build_number":14090}"#)
+        );
+
+        assert_eq!(
+            index.lookup("/offsets/client.dll/dwEntityList").as_deref(),
+            Some("30489832")
+        );
+
+        assert_eq!(
+            index
+                .lookup("/schemas/client.dll/C_BaseEntity/m_iHealth?fresh")
+                .as_deref(),
+            Some("836")
+        );
+
+        assert_eq!(
+            index.lookup("/schemas/client.dll/C_BaseEntity").as_deref(),
+            Some(r#"{"m_iHealth":836,"m_iTeamNum":995}"#)
+        );
+
+        assert_eq!(index.lookup("/offsets/client.dll/dwMissing"), None);
+        assert_eq!(index.lookup("/buttons"), None);
+
+        // The hash only depends on the values.
+        let hash = index.content_hash();
+
+        index
+            .schemas
+            .get_mut("client.dll")
+            .unwrap()
+            .get_mut("C_BaseEntity")
+            .unwrap()
+            .insert("m_iHealth".to_string(), 0x348);
+
+        assert_ne!(index.content_hash(), hash);
+    }
+}
@@ -1,5 +1,14 @@
+use std::mem;
+
 use memflow::prelude::v1::*;
 
+/// The largest blob that is read in one piece. Blobs larger than this are left to be read on
+/// demand.
+const MAX_BLOB_LEN: usize = 0x100_0000;
+
+/// The number of data bytes read along with each blob header.
+const HEAD_READ_LEN: usize = 0x1000;
+
 #[repr(u32)]
 pub enum MemoryPoolGrowType {
     None = 0,
@@ -38,3 +47,60 @@ pub struct UtlMemoryPoolBase {
     pub total_size: i32,                                // 0x0078
     pad_007c: [u8; 0x4],                                // 0x007C
 }
+
+impl UtlMemoryPoolBase {
+    /// Reads the contents of every blob in the pool. Each step of the blob list walk reads the
+    /// header together with the first [`HEAD_READ_LEN`] bytes of data, so that small blobs need no
+    /// further reads. The remainders of larger blobs are then read in a single batch.
+    ///
+    /// Returns the address of each blob along with a copy of its memory, starting at the blob
+    /// header.
+    pub fn read_blobs(&self, mem: &mut impl MemoryView) -> Result<Vec<(Address, Vec<u8>)>> {
+        let data_offset = mem::offset_of!(Blob, data);
+
+        // The number of bytes already read is kept with each blob.
+        let mut blobs = Vec::with_capacity(self.blob_count as usize);
+
+        let mut cur_blob = self.blob_head;
+        let mut count = 0;
+
+        while !cur_blob.is_null() && count < self.blob_count as usize {
+            let mut buf = vec![0; data_offset + HEAD_READ_LEN];
+
+            // Reads past the end of a small blob may fail, which leaves the excess zeroed.
+            mem.read_raw_into(cur_blob.address(), &mut buf).data_part()?;
+
+            let mut blob = Blob::zeroed();
+
+            blob.as_bytes_mut().copy_from_slice(&buf[..mem::size_of::<Blob>()]);
+
+            if blob.num_bytes > 0 && blob.num_bytes as usize <= MAX_BLOB_LEN {
+                let read_len = buf.len();
+
+                buf.resize(data_offset + blob.num_bytes as usize, 0);
+
+                blobs.push((cur_blob.address(), buf, read_len));
+            }
+
+            cur_blob = blob.next;
+            count += 1;
+        }
+
+        if blobs.iter().any(|(_, buf, read_len)| buf.len() > *read_len) {
+            let mut batcher = mem.batcher();
+
+            for (addr, buf, read_len) in &mut blobs {
+                if buf.len() > *read_len {
+                    batcher.read_raw_into(*addr + *read_len, &mut buf[*read_len..]);
+                }
+            }
+
+            batcher.commit_rw().data_part()?;
+        }
+
+        Ok(blobs
+            .into_iter()
+            .map(|(addr, buf, _)| (addr, buf))
+            .collect())
+    }
+}
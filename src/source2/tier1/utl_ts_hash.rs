@@ -1,3 +1,5 @@
+use std::mem;
+
 use memflow::prelude::v1::*;
 
 use super::UtlMemoryPoolBase;
@@ -61,50 +63,137 @@ impl<D: Pod, const C: usize, K: Pod> UtlTsHash<D, C, K> {
         let blocks_alloc = self.blocks_alloc() as usize;
         let peak_alloc = self.peak_count() as usize;
 
-        let mut allocated_list = Vec::with_capacity(peak_alloc);
-        let mut unallocated_list = Vec::with_capacity(blocks_alloc);
+        let allocated_list = self.allocated_elements(mem, blocks_alloc)?;
+        let unallocated_list = self.unallocated_elements(mem, peak_alloc)?;
+
+        Ok(if unallocated_list.len() > allocated_list.len() {
+            unallocated_list
+        } else {
+            allocated_list
+        })
+    }
+
+    /// Walks the `first_uncommitted` chains of all buckets in lockstep, reading the next node of
+    /// every live chain in a single batch per depth.
+    fn allocated_elements(
+        &self,
+        mem: &mut impl MemoryView,
+        limit: usize,
+    ) -> Result<Vec<Pointer64<D>>> {
+        let mut chains: Vec<Vec<HashFixedDataInternal<D, K>>> =
+            self.buckets.iter().map(|_| Vec::new()).collect();
+
+        let mut cursors: Vec<_> = self
+            .buckets
+            .iter()
+            .map(|bucket| bucket.first_uncommitted)
+            .enumerate()
+            .filter(|(_, element)| !element.is_null())
+            .collect();
+
+        // No chain can be longer than the number of allocated blocks, unless it's cyclic.
+        for _ in 0..=limit {
+            if cursors.is_empty() {
+                break;
+            }
+
+            let mut elements: Vec<HashFixedDataInternal<D, K>> =
+                cursors.iter().map(|_| Pod::zeroed()).collect();
+
+            let mut batcher = mem.batcher();
+
+            for ((_, cur_element), element) in cursors.iter().zip(elements.iter_mut()) {
+                batcher.read_into(cur_element.address(), element);
+            }
+
+            batcher.commit_rw().data_part()?;
+
+            drop(batcher);
+
+            cursors = cursors
+                .into_iter()
+                .zip(elements)
+                .filter_map(|((i, _), element)| {
+                    let next = element.next;
+
+                    chains[i].push(element);
 
-        for bucket in &self.buckets {
-            let mut cur_element = bucket.first_uncommitted;
+                    (!next.is_null()).then_some((i, next))
+                })
+                .collect();
+        }
 
-            while !cur_element.is_null() {
-                let element = mem.read_ptr(cur_element).data_part()?;
+        // Collect the elements in bucket order, stopping each chain once the limit is reached.
+        let mut allocated_list = Vec::with_capacity(limit);
 
+        for chain in chains {
+            for element in chain {
                 if !element.data.is_null() {
                     allocated_list.push(element.data);
                 }
 
-                if allocated_list.len() >= blocks_alloc {
+                if allocated_list.len() >= limit {
                     break;
                 }
-
-                cur_element = element.next;
             }
         }
 
+        Ok(allocated_list)
+    }
+
+    /// Walks the free list of the memory pool. Its nodes live inside the pool's blobs, so these are
+    /// read in bulk first and nodes are resolved from the copies where possible.
+    fn unallocated_elements(
+        &self,
+        mem: &mut impl MemoryView,
+        limit: usize,
+    ) -> Result<Vec<Pointer64<D>>> {
+        if self.entry_mem.free_list_head.is_null() {
+            return Ok(Vec::new());
+        }
+
+        let blobs = self.entry_mem.read_blobs(mem)?;
+
+        let mut unallocated_list = Vec::with_capacity(limit);
+
         let mut cur_blob =
             Pointer64::<HashAllocatedBlob<D>>::from(self.entry_mem.free_list_head.address());
 
         while !cur_blob.is_null() {
-            let blob = mem.read_ptr(cur_blob).data_part()?;
+            let blob = match find_in_blobs(&blobs, cur_blob.address()) {
+                Some(blob) => blob,
+                None => mem.read_ptr(cur_blob).data_part()?,
+            };
 
             if !blob.data.is_null() {
                 unallocated_list.push(blob.data);
             }
 
-            if unallocated_list.len() >= peak_alloc {
+            if unallocated_list.len() >= limit {
                 break;
             }
 
             cur_blob = blob.next;
         }
 
-        Ok(if unallocated_list.len() > allocated_list.len() {
-            unallocated_list
-        } else {
-            allocated_list
-        })
+        Ok(unallocated_list)
     }
 }
 
+/// Reads a `T` at `addr` from a copy of a blob, if the blob contains it entirely.
+fn find_in_blobs<T: Pod + Sized>(blobs: &[(Address, Vec<u8>)], addr: Address) -> Option<T> {
+    let addr = addr.to_umem();
+
+    blobs.iter().find_map(|(base, buf)| {
+        let start = addr.checked_sub(base.to_umem())? as usize;
+        let bytes = buf.get(start..start.checked_add(mem::size_of::<T>())?)?;
+
+        let mut value = T::zeroed();
+
+        value.as_bytes_mut().copy_from_slice(bytes);
+
+        Some(value)
+    })
+}
+
 unsafe impl<D: 'static, const C: usize, K: 'static> Pod for UtlTsHash<D, C, K> {}
@@ -0,0 +1,160 @@
+use std::collections::{BTreeSet, HashSet};
+use std::mem;
+use std::sync::{Arc, Mutex};
+
+use anyhow::{Result, anyhow};
+
+use memflow::prelude::v1::*;
+
+use super::Target;
+use super::snapshot::{self, PAGE_LEN, Snapshot};
+
+#[derive(Default)]
+struct CaptureState {
+    snapshot: Snapshot,
+
+    /// The pages the target failed to read, which are not retried.
+    unreadable: HashSet<u64>,
+}
+
+/// Records every page read from a target, along with its module list.
+///
+/// Reads are widened to whole pages, which are fetched from the target once and then served from
+/// the recording. That way, every read made during capture can be served by [`Replay`](super::Replay)
+/// later on. Clones share the same recording.
+#[derive(Clone)]
+pub struct Capture<P> {
+    inner: P,
+    state: Arc<Mutex<CaptureState>>,
+}
+
+impl<P: Target> Capture<P> {
+    pub fn new(inner: P) -> Self {
+        Self {
+            inner,
+            state: Arc::default(),
+        }
+    }
+
+    /// Returns everything recorded so far, and starts a new recording.
+    pub fn take_snapshot(&self) -> Snapshot {
+        let mut state = self.state.lock().unwrap();
+
+        mem::take(&mut state.snapshot)
+    }
+
+    /// Reads all given pages that weren't read before from the target in a single batch.
+    fn fetch(&mut self, pages: BTreeSet<u64>) -> memflow::error::Result<()> {
+        let mut bufs: Vec<_> = pages
+            .into_iter()
+            .map(|addr| (addr, vec![0; PAGE_LEN].into_boxed_slice()))
+            .collect();
+
+        let mut read = HashSet::new();
+
+        {
+            let mut inp = bufs.iter_mut().map(|(addr, buf)| {
+                CTup3(
+                    Address::from(*addr),
+                    Address::from(*addr),
+                    CSliceMut::from(&mut buf[..]),
+                )
+            });
+
+            let mut on_read = |CTup2(addr, _): ReadData| {
+                read.insert(addr.to_umem());
+
+                true
+            };
+
+            let mut on_fail = |_: ReadData| true;
+
+            self.inner.read_raw_iter(MemOps {
+                inp: (&mut inp).into(),
+                out: Some(&mut (&mut on_read).into()),
+                out_fail: Some(&mut (&mut on_fail).into()),
+            })?;
+        }
+
+        let mut state = self.state.lock().unwrap();
+
+        for (addr, buf) in bufs {
+            if read.contains(&addr) {
+                state.snapshot.pages.insert(addr, buf);
+            } else {
+                state.unreadable.insert(addr);
+            }
+        }
+
+        Ok(())
+    }
+}
+
+impl<P: Target> Target for Capture<P> {
+    fn modules(&mut self) -> Result<Vec<ModuleInfo>> {
+        let modules = self.inner.modules()?;
+
+        let mut state = self.state.lock().unwrap();
+
+        for module in &modules {
+            let module = (module.name.to_string(), module.base, module.size);
+
+            if !state.snapshot.modules.contains(&module) {
+                state.snapshot.modules.push(module);
+            }
+        }
+
+        Ok(modules)
+    }
+
+    fn module(&mut self, name: &str) -> Result<ModuleInfo> {
+        // Looking up a module by name walks the module list anyway.
+        self.modules()?
+            .into_iter()
+            .find(|module| module.name.as_ref() == name)
+            .ok_or_else(|| anyhow!("module not found: {}", name))
+    }
+}
+
+impl<P: Target> MemoryView for Capture<P> {
+    fn read_raw_iter(
+        &mut self,
+        MemOps { inp, out, out_fail }: ReadRawMemOps,
+    ) -> memflow::error::Result<()> {
+        let reads: Vec<_> = inp.collect();
+
+        let missing: BTreeSet<_> = {
+            let state = self.state.lock().unwrap();
+
+            reads
+                .iter()
+                .flat_map(|CTup3(addr, _, data)| snapshot::pages(*addr, data.len()))
+                .filter(|addr| {
+                    !state.snapshot.pages.contains_key(addr) && !state.unreadable.contains(addr)
+                })
+                .collect()
+        };
+
+        if !missing.is_empty() {
+            self.fetch(missing)?;
+        }
+
+        let mut reads = reads.into_iter();
+
+        self.state.lock().unwrap().snapshot.read_iter(MemOps {
+            inp: (&mut reads).into(),
+            out,
+            out_fail,
+        });
+
+        Ok(())
+    }
+
+    fn write_raw_iter(&mut self, data: WriteRawMemOps) -> memflow::error::Result<()> {
+        self.inner.write_raw_iter(data)
+    }
+
+    fn metadata(&self) -> MemoryViewMetadata {
+        self.inner.metadata()
+    }
+}
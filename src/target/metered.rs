@@ -0,0 +1,80 @@
+use std::sync::Arc;
+use std::time::Instant;
+
+use anyhow::Result;
+
+use memflow::prelude::v1::*;
+
+use super::Target;
+
+use crate::metrics::Metrics;
+
+/// Counts every read made through a target, attributed to the stage set with
+/// [`Target::set_stage`]. Clones keep the stage of the original.
+#[derive(Clone)]
+pub struct Metered<P> {
+    inner: P,
+    metrics: Arc<Metrics>,
+    stage: &'static str,
+}
+
+impl<P: Target> Metered<P> {
+    pub fn new(inner: P, metrics: Arc<Metrics>) -> Self {
+        Self {
+            inner,
+            metrics,
+            stage: "other",
+        }
+    }
+}
+
+impl<P: Target> Target for Metered<P> {
+    fn modules(&mut self) -> Result<Vec<ModuleInfo>> {
+        self.inner.modules()
+    }
+
+    fn module(&mut self, name: &str) -> Result<ModuleInfo> {
+        self.inner.module(name)
+    }
+
+    fn set_stage(&mut self, stage: &'static str) {
+        self.stage = stage;
+    }
+}
+
+impl<P: Target> MemoryView for Metered<P> {
+    fn read_raw_iter(
+        &mut self,
+        MemOps { inp, out, out_fail }: ReadRawMemOps,
+    ) -> memflow::error::Result<()> {
+        let (mut reads, mut bytes) = (0, 0);
+
+        let mut inp = inp.inspect(|CTup3(_, _, data)| {
+            reads += 1;
+            bytes += data.len() as u64;
+        });
+
+        let now = Instant::now();
+
+        let result = self.inner.read_raw_iter(MemOps {
+            inp: (&mut inp).into(),
+            out,
+            out_fail,
+        });
+
+        drop(inp);
+
+        self.metrics
+            .record_reads(self.stage, reads, bytes, now.elapsed());
+
+        result
+    }
+
+    fn write_raw_iter(&mut self, data: WriteRawMemOps) -> memflow::error::Result<()> {
+        self.inner.write_raw_iter(data)
+    }
+
+    fn metadata(&self) -> MemoryViewMetadata {
+        self.inner.metadata()
+    }
+}
@@ -0,0 +1,44 @@
+pub use capture::Capture;
+pub use metered::Metered;
+pub use offline::Offline;
+pub use replay::Replay;
+pub use snapshot::Snapshot;
+pub use spec::TargetSpec;
+
+use anyhow::Result;
+
+use memflow::prelude::v1::*;
+
+mod capture;
+mod metered;
+mod offline;
+mod replay;
+mod snapshot;
+mod spec;
+
+/// The process being dumped: its memory and its loaded modules.
+///
+/// Every memflow process is a target. [`Capture`] records everything read from a target into a
+/// [`Snapshot`], which [`Replay`] serves again without the game running. [`Offline`] serves the
+/// module files of a game installation instead.
+pub trait Target: MemoryView {
+    fn modules(&mut self) -> Result<Vec<ModuleInfo>>;
+
+    fn module(&mut self, name: &str) -> Result<ModuleInfo>;
+
+    /// Names the stage that upcoming reads are made for, see [`Metered`].
+    #[inline]
+    fn set_stage(&mut self, _stage: &'static str) {}
+}
+
+impl<P: Process + MemoryView> Target for P {
+    #[inline]
+    fn modules(&mut self) -> Result<Vec<ModuleInfo>> {
+        Ok(self.module_list()?)
+    }
+
+    #[inline]
+    fn module(&mut self, name: &str) -> Result<ModuleInfo> {
+        Ok(self.module_by_name(name)?)
+    }
+}
@@ -0,0 +1,235 @@
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+
+use anyhow::{Result, anyhow, bail};
+
+use memflow::prelude::v1::*;
+
+use pelite::pe64::{Pe, PeFile};
+
+use super::Target;
+
+/// The directories of a game installation that hold module images.
+const MODULE_DIRS: &[&str] = &["game/bin/win64", "game/csgo/bin/win64", ""];
+
+/// Serves module images straight from the files of a game installation, without the game
+/// running.
+///
+/// Every image is placed at its preferred base address in its virtual layout. Reads are
+/// translated to file offsets through the section table, and the parts of sections that aren't
+/// backed by the file read as zero, like they do right after loading. Only what is present in the
+/// files on disk can be found this way, which rules out everything that is built at runtime.
+/// Clones share the same files.
+#[derive(Clone)]
+pub struct Offline {
+    images: Arc<[OfflineImage]>,
+}
+
+struct OfflineImage {
+    name: String,
+    base: u64,
+    size: u64,
+
+    /// The virtual address, file offset and file-backed length of the headers and of every
+    /// section.
+    mappings: Vec<(u64, usize, usize)>,
+
+    file: Vec<u8>,
+}
+
+impl Offline {
+    /// Opens the images of the given modules in the game directory `game_dir`.
+    pub fn open(game_dir: &Path, module_names: &[&str]) -> Result<Self> {
+        let images = module_names
+            .iter()
+            .map(|module_name| {
+                let file_path = find_module(game_dir, module_name).ok_or_else(|| {
+                    anyhow!(
+                        "module not found in {}: {}",
+                        game_dir.display(),
+                        module_name
+                    )
+                })?;
+
+                OfflineImage::open(module_name, &file_path)
+            })
+            .collect::<Result<_>>()?;
+
+        Ok(Self { images })
+    }
+
+    fn image(&self, addr: u64, len: usize) -> Option<&OfflineImage> {
+        self.images
+            .iter()
+            .find(|image| addr >= image.base && addr + len as u64 <= image.base + image.size)
+    }
+}
+
+impl OfflineImage {
+    fn open(name: &str, file_path: &Path) -> Result<Self> {
+        let file = fs::read(file_path)?;
+
+        let pe = PeFile::from_bytes(&file)?;
+        let header = pe.optional_header();
+
+        let mut mappings = vec![(0, 0, header.SizeOfHeaders as usize)];
+
+        for section in pe.section_headers().iter() {
+            let virtual_size = match section.VirtualSize {
+                0 => section.SizeOfRawData,
+                size => size,
+            };
+
+            mappings.push((
+                section.VirtualAddress as u64,
+                section.PointerToRawData as usize,
+                section.SizeOfRawData.min(virtual_size) as usize,
+            ));
+        }
+
+        if mappings
+            .iter()
+            .any(|&(_, offset, len)| offset + len > file.len())
+        {
+            bail!("truncated module image: {}", file_path.display());
+        }
+
+        Ok(Self {
+            name: name.to_string(),
+            base: header.ImageBase,
+            size: header.SizeOfImage as u64,
+            mappings,
+            file,
+        })
+    }
+
+    /// Copies the memory at `rva` into `out`, as it would look right after loading the image.
+    fn read(&self, rva: u64, out: &mut [u8]) {
+        out.fill(0);
+
+        let end = rva + out.len() as u64;
+
+        for &(start, offset, len) in &self.mappings {
+            let (from, to) = (rva.max(start), end.min(start + len as u64));
+
+            if from >= to {
+                continue;
+            }
+
+            let src = offset + (from - start) as usize;
+            let dst = (from - rva) as usize;
+            let len = (to - from) as usize;
+
+            out[dst..dst + len].copy_from_slice(&self.file[src..src + len]);
+        }
+    }
+}
+
+impl Target for Offline {
+    fn modules(&mut self) -> Result<Vec<ModuleInfo>> {
+        Ok(self
+            .images
+            .iter()
+            .map(|image| ModuleInfo {
+                address: Address::from(image.base),
+                parent_process: Address::null(),
+                base: Address::from(image.base),
+                size: image.size as umem,
+                name: image.name.as_str().into(),
+                path: image.name.as_str().into(),
+                arch: ArchitectureIdent::X86(64, false),
+            })
+            .collect())
+    }
+
+    fn module(&mut self, name: &str) -> Result<ModuleInfo> {
+        self.modules()?
+            .into_iter()
+            .find(|module| module.name.as_ref() == name)
+            .ok_or_else(|| anyhow!("module not found: {}", name))
+    }
+}
+
+impl MemoryView for Offline {
+    fn read_raw_iter(
+        &mut self,
+        MemOps { inp, out, out_fail }: ReadRawMemOps,
+    ) -> memflow::error::Result<()> {
+        let (mut out, mut out_fail) = (out, out_fail);
+
+        for CTup3(addr, meta_addr, mut data) in inp {
+            let callback = match self.image(addr.to_umem(), data.len()) {
+                Some(image) => {
+                    image.read(addr.to_umem() - image.base, &mut data);
+
+                    out.as_deref_mut()
+                }
+                None => out_fail.as_deref_mut(),
+            };
+
+            if let Some(callback) = callback {
+                callback.call(CTup2(meta_addr, data));
+            }
+        }
+
+        Ok(())
+    }
+
+    fn write_raw_iter(&mut self, _data: WriteRawMemOps) -> memflow::error::Result<()> {
+        Err(Error(ErrorOrigin::Memory, ErrorKind::NotImplemented))
+    }
+
+    fn metadata(&self) -> MemoryViewMetadata {
+        MemoryViewMetadata {
+            max_address: Address::from(u64::MAX),
+            real_size: u64::MAX as umem,
+            readonly: true,
+            little_endian: true,
+            arch_bits: 64,
+        }
+    }
+}
+
+/// Returns the path of a module image in a game directory.
+fn find_module(game_dir: &Path, module_name: &str) -> Option<PathBuf> {
+    MODULE_DIRS
+        .iter()
+        .map(|dir| game_dir.join(dir).join(module_name))
+        .find(|file_path| file_path.is_file())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn reads_virtual_layout() {
+        let image = OfflineImage {
+            name: "client.dll".to_string(),
+            base: 0x180000000,
+            size: 0x2000,
+            mappings: vec![(0, 0, 0x10), (0x1000, 0x10, 8)],
+            file: (0..0x18).collect(),
+        };
+
+        // The end of a section that isn't backed by the file reads as zero.
+        let mut buf = [0xff; 8];
+
+        image.read(0x1004, &mut buf);
+
+        assert_eq!(buf, [0x14, 0x15, 0x16, 0x17, 0, 0, 0, 0]);
+
+        // So does the gap between the headers and the first section.
+        image.read(0xe, &mut buf);
+
+        assert_eq!(buf, [0xe, 0xf, 0, 0, 0, 0, 0, 0]);
+
+        let offline = Offline {
+            images: Arc::from([image]),
+        };
+
+        assert!(offline.image(0x180001ff8, 8).is_some());
+        assert!(offline.image(0x180001ffc, 8).is_none());
+    }
+}
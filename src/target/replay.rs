@@ -0,0 +1,101 @@
+#[cfg(test)]
+use std::env;
+use std::path::Path;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+use std::time::Duration;
+
+use anyhow::{Result, anyhow};
+
+use memflow::prelude::v1::*;
+
+use super::{Snapshot, Target};
+
+/// Serves the memory and module list recorded by [`Capture`](super::Capture), so that the dumper
+/// can run and be measured without the game.
+///
+/// Every batch of reads is delayed by a fixed latency, to mimic the round trip of a real
+/// connector. Clones share the same snapshot and batch count.
+#[derive(Clone)]
+pub struct Replay {
+    snapshot: Arc<Snapshot>,
+    latency: Duration,
+    batches: Arc<AtomicUsize>,
+}
+
+impl Replay {
+    pub fn new(snapshot: Snapshot, latency: Duration) -> Self {
+        Self {
+            snapshot: Arc::new(snapshot),
+            latency,
+            batches: Arc::default(),
+        }
+    }
+
+    pub fn open(path: &Path, latency: Duration) -> Result<Self> {
+        Ok(Self::new(Snapshot::load(path)?, latency))
+    }
+
+    /// Opens the snapshot used by the benchmarks, which is read from the path in the
+    /// `CS2_DUMPER_SNAPSHOT` environment variable (`cs2-dumper.snapshot` by default). The latency
+    /// in microseconds is read from `CS2_DUMPER_LATENCY`.
+    #[cfg(test)]
+    pub fn open_bench() -> Result<Self> {
+        let path = env::var("CS2_DUMPER_SNAPSHOT").unwrap_or("cs2-dumper.snapshot".to_string());
+
+        let latency = env::var("CS2_DUMPER_LATENCY")
+            .ok()
+            .and_then(|latency| latency.parse().ok())
+            .unwrap_or_default();
+
+        Self::open(Path::new(&path), Duration::from_micros(latency))
+    }
+
+    /// The number of read batches served so far, i.e. the number of round trips a real connector
+    /// would have made.
+    pub fn batches(&self) -> usize {
+        self.batches.load(Ordering::Relaxed)
+    }
+}
+
+impl Target for Replay {
+    fn modules(&mut self) -> Result<Vec<ModuleInfo>> {
+        Ok(self.snapshot.module_info())
+    }
+
+    fn module(&mut self, name: &str) -> Result<ModuleInfo> {
+        self.modules()?
+            .into_iter()
+            .find(|module| module.name.as_ref() == name)
+            .ok_or_else(|| anyhow!("module not found: {}", name))
+    }
+}
+
+impl MemoryView for Replay {
+    fn read_raw_iter(&mut self, data: ReadRawMemOps) -> memflow::error::Result<()> {
+        self.batches.fetch_add(1, Ordering::Relaxed);
+
+        if !self.latency.is_zero() {
+            thread::sleep(self.latency);
+        }
+
+        self.snapshot.read_iter(data);
+
+        Ok(())
+    }
+
+    fn write_raw_iter(&mut self, _data: WriteRawMemOps) -> memflow::error::Result<()> {
+        Err(Error(ErrorOrigin::Memory, ErrorKind::NotImplemented))
+    }
+
+    fn metadata(&self) -> MemoryViewMetadata {
+        MemoryViewMetadata {
+            max_address: Address::from(u64::MAX),
+            real_size: u64::MAX as umem,
+            readonly: true,
+            little_endian: true,
+            arch_bits: 64,
+        }
+    }
+}
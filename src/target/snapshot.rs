@@ -0,0 +1,238 @@
+use std::collections::HashMap;
+use std::fs::File;
+use std::io::{BufReader, BufWriter, Read, Write};
+use std::path::Path;
+
+use anyhow::{Result, bail};
+
+use memflow::prelude::v1::*;
+
+const MAGIC: &[u8; 4] = b"CS2S";
+const VERSION: u32 = 1;
+
+/// The granularity at which memory is captured.
+pub const PAGE_LEN: usize = 0x1000;
+
+/// The module list and every memory page read from a target.
+///
+/// The file layout is little-endian: the magic and version, the module count followed by the base,
+/// size and name of every module, and the page count followed by the address and contents of
+/// every page.
+#[derive(Debug, Default)]
+pub struct Snapshot {
+    pub modules: Vec<(String, Address, umem)>,
+
+    /// The contents of every captured page, by page address.
+    pub pages: HashMap<u64, Box<[u8]>>,
+}
+
+impl Snapshot {
+    pub fn load(path: &Path) -> Result<Self> {
+        let mut input = BufReader::new(File::open(path)?);
+
+        let mut magic = [0; 4];
+
+        input.read_exact(&mut magic)?;
+
+        if &magic != MAGIC || read_u32(&mut input)? != VERSION {
+            bail!("unsupported snapshot: {}", path.display());
+        }
+
+        let module_count = read_u32(&mut input)?;
+
+        let modules = (0..module_count)
+            .map(|_| {
+                let base = Address::from(read_u64(&mut input)?);
+                let size = read_u64(&mut input)? as umem;
+
+                let mut name = vec![0; read_u32(&mut input)? as usize];
+
+                input.read_exact(&mut name)?;
+
+                Ok((String::from_utf8(name)?, base, size))
+            })
+            .collect::<Result<_>>()?;
+
+        let page_count = read_u64(&mut input)?;
+
+        let pages = (0..page_count)
+            .map(|_| {
+                let addr = read_u64(&mut input)?;
+
+                let mut page = vec![0; PAGE_LEN].into_boxed_slice();
+
+                input.read_exact(&mut page)?;
+
+                Ok((addr, page))
+            })
+            .collect::<Result<_>>()?;
+
+        Ok(Self { modules, pages })
+    }
+
+    pub fn save(&self, path: &Path) -> Result<()> {
+        let mut out = BufWriter::new(File::create(path)?);
+
+        out.write_all(MAGIC)?;
+        out.write_all(&VERSION.to_le_bytes())?;
+        out.write_all(&(self.modules.len() as u32).to_le_bytes())?;
+
+        for (name, base, size) in &self.modules {
+            out.write_all(&base.to_umem().to_le_bytes())?;
+            out.write_all(&(*size as u64).to_le_bytes())?;
+            out.write_all(&(name.len() as u32).to_le_bytes())?;
+            out.write_all(name.as_bytes())?;
+        }
+
+        // Sorted, so that capturing the same memory twice yields the same file.
+        let mut addrs: Vec<_> = self.pages.keys().copied().collect();
+
+        addrs.sort_unstable();
+
+        out.write_all(&(addrs.len() as u64).to_le_bytes())?;
+
+        for addr in addrs {
+            out.write_all(&addr.to_le_bytes())?;
+            out.write_all(&self.pages[&addr])?;
+        }
+
+        out.flush()?;
+
+        Ok(())
+    }
+
+    pub fn module_info(&self) -> Vec<ModuleInfo> {
+        self.modules
+            .iter()
+            .map(|(name, base, size)| ModuleInfo {
+                address: *base,
+                parent_process: Address::null(),
+                base: *base,
+                size: *size,
+                name: name.as_str().into(),
+                path: name.as_str().into(),
+                arch: ArchitectureIdent::X86(64, false),
+            })
+            .collect()
+    }
+
+    /// Copies the memory at `addr` into `out`. Returns `false` if any of it wasn't captured, in
+    /// which case that part is zeroed.
+    pub fn read(&self, addr: Address, mut out: &mut [u8]) -> bool {
+        let mut complete = true;
+        let mut addr = addr.to_umem();
+
+        while !out.is_empty() {
+            let page_addr = addr - addr % PAGE_LEN as u64;
+            let offset = (addr - page_addr) as usize;
+            let len = out.len().min(PAGE_LEN - offset);
+
+            let (chunk, rest) = out.split_at_mut(len);
+
+            match self.pages.get(&page_addr) {
+                Some(page) => chunk.copy_from_slice(&page[offset..offset + len]),
+                None => {
+                    chunk.fill(0);
+
+                    complete = false;
+                }
+            }
+
+            addr += len as u64;
+            out = rest;
+        }
+
+        complete
+    }
+
+    /// Serves a batch of reads from the captured pages.
+    pub fn read_iter(&self, MemOps { inp, out, out_fail }: ReadRawMemOps) {
+        let (mut out, mut out_fail) = (out, out_fail);
+
+        for CTup3(addr, meta_addr, mut data) in inp {
+            let callback = if self.read(addr, &mut data) {
+                out.as_deref_mut()
+            } else {
+                out_fail.as_deref_mut()
+            };
+
+            if let Some(callback) = callback {
+                callback.call(CTup2(meta_addr, data));
+            }
+        }
+    }
+}
+
+/// Returns the addresses of all pages overlapping `len` bytes at `addr`.
+pub fn pages(addr: Address, len: usize) -> impl Iterator<Item = u64> {
+    let start = addr.to_umem() - addr.to_umem() % PAGE_LEN as u64;
+    let end = addr.to_umem() + len as u64;
+
+    (start..end).step_by(PAGE_LEN)
+}
+
+fn read_u32(input: &mut impl Read) -> Result<u32> {
+    let mut buf = [0; 4];
+
+    input.read_exact(&mut buf)?;
+
+    Ok(u32::from_le_bytes(buf))
+}
+
+fn read_u64(input: &mut impl Read) -> Result<u64> {
+    let mut buf = [0; 8];
+
+    input.read_exact(&mut buf)?;
+
+    Ok(u64::from_le_bytes(buf))
+}
+
+#[cfg(test)]
+mod tests {
+    use std::env;
+
+    use super::*;
+
+    #[test]
+    fn round_trip() -> Result<()> {
+        let mut snapshot = Snapshot {
+            modules: vec![("client.dll".to_string(), Address::from(0x10000u64), 0x3000)],
+            ..Default::default()
+        };
+
+        let page: Vec<_> = (0..PAGE_LEN).map(|i| i as u8).collect();
+
+        snapshot
+            .pages
+            .insert(0x10000, page.clone().into_boxed_slice());
+        snapshot.pages.insert(0x11000, page.into_boxed_slice());
+
+        let path = env::temp_dir().join(format!("cs2-dumper-{}.snapshot", std::process::id()));
+
+        snapshot.save(&path)?;
+
+        let snapshot = Snapshot::load(&path)?;
+
+        std::fs::remove_file(&path)?;
+
+        assert_eq!(snapshot.modules.len(), 1);
+        assert_eq!(snapshot.module_info()[0].size, 0x3000);
+
+        // Reads spanning two captured pages succeed.
+        let mut buf = [0; 4];
+
+        assert!(snapshot.read(Address::from(0x10ffeu64), &mut buf));
+        assert_eq!(buf, [0xfe, 0xff, 0x00, 0x01]);
+
+        // Reads touching a page that wasn't captured fail, and are zeroed there.
+        assert!(!snapshot.read(Address::from(0x11ffeu64), &mut buf));
+        assert_eq!(buf, [0xfe, 0xff, 0x00, 0x00]);
+
+        assert_eq!(
+            pages(Address::from(0x10ffeu64), 4).collect::<Vec<_>>(),
+            [0x10000, 0x11000]
+        );
+
+        Ok(())
+    }
+}
@@ -0,0 +1,91 @@
+use std::str::FromStr;
+
+use anyhow::{Error, Result, bail};
+
+use memflow::prelude::v1::*;
+
+/// One of several targets to dump, written as `NAME=[CONNECTOR[:ARGS]][@PID]`.
+///
+/// Without a connector, the native one is used. Without a process ID, the process is looked up by
+/// name.
+#[derive(Clone, Debug, PartialEq)]
+pub struct TargetSpec {
+    pub name: String,
+    pub connector: Option<String>,
+    pub connector_args: Option<String>,
+    pub pid: Option<Pid>,
+}
+
+impl FromStr for TargetSpec {
+    type Err = Error;
+
+    fn from_str(s: &str) -> Result<Self> {
+        let Some((name, rest)) = s.split_once('=') else {
+            bail!("missing target name: {}", s);
+        };
+
+        // The name is used as the target's output directory.
+        if name.is_empty()
+            || !name
+                .chars()
+                .all(|c| c.is_ascii_alphanumeric() || matches!(c, '-' | '_' | '.'))
+            || name.starts_with('.')
+        {
+            bail!("invalid target name: {}", name);
+        }
+
+        let (connector, pid) = match rest.rsplit_once('@') {
+            Some((connector, pid)) => match pid.parse() {
+                Ok(pid) => (connector, Some(pid)),
+                Err(_) => bail!("invalid process id: {}", pid),
+            },
+            None => (rest, None),
+        };
+
+        let (connector, connector_args) = match connector.split_once(':') {
+            Some((connector, args)) => (connector, Some(args.to_string())),
+            None => (connector, None),
+        };
+
+        Ok(Self {
+            name: name.to_string(),
+            connector: (!connector.is_empty()).then(|| connector.to_string()),
+            connector_args,
+            pid,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn parse() -> Result<()> {
+        assert_eq!(
+            "beta=kvm:vm-beta,key=value@4242".parse::<TargetSpec>()?,
+            TargetSpec {
+                name: "beta".to_string(),
+                connector: Some("kvm".to_string()),
+                connector_args: Some("vm-beta,key=value".to_string()),
+                pid: Some(4242),
+            }
+        );
+
+        assert_eq!(
+            "local=@1234".parse::<TargetSpec>()?,
+            TargetSpec {
+                name: "local".to_string(),
+                connector: None,
+                connector_args: None,
+                pid: Some(1234),
+            }
+        );
+
+        assert!("qemu".parse::<TargetSpec>().is_err());
+        assert!("../up=qemu".parse::<TargetSpec>().is_err());
+        assert!("release=qemu@cs2.exe".parse::<TargetSpec>().is_err());
+
+        Ok(())
+    }
+}